@@ -0,0 +1,32 @@
+#include <textureAtlas.hpp>
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "Incorrect argument list\n"
+                  << "\tPlease provide:\n"
+                  << "\t1 - Path to write the atlas manifest csv to, pages are written next to it\n"
+                  << "\t2... - Paths of the images to pack, as the game loads them"
+                  << std::endl;
+        return 1;
+    }
+
+    std::string manifestPath { argv[1] };
+
+    // nothing is drawn, so there's no need for a graphics context
+    TextureAtlas& atlas = TextureAtlas::get();
+    atlas.setHeadless(true);
+
+    for (int i = 2; i < argc; i++)
+        atlas.load(argv[i]);
+
+    atlas.saveToFiles(manifestPath);
+
+    std::cout << "Packed " << atlas.getRegionCount() << " images into "
+              << atlas.getPageCount() << " pages: " << manifestPath
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <csvParser.hpp>
+#include <csvScanner.hpp>
+#include <tileLayout.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The character at a time parser that CSVParser used to be, kept as a baseline.
+namespace legacy {
+
+std::string getNextLine(std::istream& is, char delim = '\n') {
+    std::string s;
+
+    for (char c; !is.get(c).eof();)
+        if (c == delim) return s;
+        else s += c;
+
+    return s;
+}
+
+std::vector<std::string> splitString(const std::string& s, char delim = ',') {
+    std::vector<std::string> results;
+
+    std::string str;
+    for (auto& c : s) {
+        if (c == delim) {
+            results.push_back(str);
+            str = "";
+        } else str += c;
+    }
+
+    if (str != "") results.push_back(str);
+
+    return results;
+}
+
+std::vector<std::vector<std::string>> parse(std::istream& is) {
+    std::vector<std::vector<std::string>> rows;
+
+    while (!is.eof())
+        rows.push_back(splitString(getNextLine(is)));
+
+    if (rows.size() > 0 && rows.back().size() == 0) rows.pop_back();
+
+    return rows;
+}
+
+}
+
+std::string generateLayout(int columns, int rows) {
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> tile(0, 321);
+
+    std::string layout;
+    layout.reserve(static_cast<std::size_t>(columns) * rows * 4);
+
+    for (int j = 0; j < rows; j++)
+    for (int i = 0; i < columns; i++) {
+        // mostly empty, like the real maps
+        layout += std::to_string(random() % 4 ? 0 : tile(random));
+        layout += i + 1 < columns ? ',' : '\n';
+    }
+
+    return layout;
+}
+
+void report(const std::string& name, std::size_t bytes, const std::function<std::size_t()>& run) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t result = run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "  " << name << ": "
+              << seconds * 1000.0 << " ms, "
+              << bytes / seconds / (1024.0 * 1024.0) << " MiB/s"
+              << " (" << result << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    int columns = argc > 1 ? std::atoi(argv[1]) : 4096;
+    int rows = argc > 2 ? std::atoi(argv[2]) : 4096;
+
+    std::cout << "Generating a " << columns << "x" << rows << " layout" << std::endl;
+    std::string layout = generateLayout(columns, rows);
+    std::cout << "  " << layout.size() / (1024.0 * 1024.0) << " MiB" << std::endl;
+
+    std::cout << "Delimiter scan" << std::endl;
+
+    std::vector<std::uint32_t> positions(layout.size());
+    std::size_t expected = CSVScanner::findDelimiters(
+        layout.data(), layout.size(), positions.data(), CSVScanner::Implementation::Scalar);
+
+    for (auto implementation : {
+        CSVScanner::Implementation::Scalar,
+        CSVScanner::Implementation::SSE2,
+        CSVScanner::Implementation::AVX2
+    }) {
+        if (!CSVScanner::isSupported(implementation)) {
+            std::cout << "  " << CSVScanner::getName(implementation) << ": unsupported" << std::endl;
+            continue;
+        }
+
+        report(CSVScanner::getName(implementation), layout.size(), [&]() {
+            // scan in blocks so the offsets fit in 32 bits, as CSVParser does
+            std::size_t count = 0;
+            for (std::size_t begin = 0; begin < layout.size(); begin += 1 << 20) {
+                std::size_t size = std::min<std::size_t>(1 << 20, layout.size() - begin);
+                count += CSVScanner::findDelimiters(layout.data() + begin, size, positions.data(), implementation);
+            }
+
+            if (count != expected)
+                throw std::runtime_error(std::string("Delimiter count mismatch for ") + CSVScanner::getName(implementation));
+
+            return count;
+        });
+    }
+
+    std::cout << "Full parse" << std::endl;
+
+    report("legacy getNextLine/splitString", layout.size(), [&]() {
+        std::stringstream stream(layout);
+        return legacy::parse(stream).size();
+    });
+
+    report("CSVParser table", layout.size(), [&]() {
+        std::stringstream stream(layout);
+        return static_cast<std::size_t>(CSVParser(stream, false).getRowCount());
+    });
+
+    std::string filename = "csvBenchmark.csv";
+    std::ofstream(filename, std::ios::binary) << layout;
+
+    report("CSVParser mapped table", layout.size(), [&]() {
+        return static_cast<std::size_t>(CSVParser(filename, false).getRowCount());
+    });
+
+    std::remove(filename.c_str());
+
+    std::cout << "TileLayout::loadFromFile by thread count" << std::endl;
+
+    std::string layoutFilename = "csvBenchmarkLayout.csv";
+    std::ofstream(layoutFilename, std::ios::binary) << "47,52,53,54,\n" << layout;
+
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double singleThreadSeconds = 0.0;
+
+    for (unsigned int threads = 1; threads <= maxThreads; threads *= 2) {
+        auto start = std::chrono::steady_clock::now();
+        TileLayout tileLayout = TileLayout::loadFromFile(layoutFilename, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (threads == 1) singleThreadSeconds = seconds;
+
+        std::cout << "  " << threads << " threads: "
+                  << seconds * 1000.0 << " ms, "
+                  << layout.size() / seconds / (1024.0 * 1024.0) << " MiB/s, "
+                  << singleThreadSeconds / seconds << "x"
+                  << " (" << tileLayout.m_gridColumns << "x" << tileLayout.m_gridRows << ")" << std::endl;
+
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+
+    std::remove(layoutFilename.c_str());
+
+    report("CSVParser::forEachCell", layout.size(), [&]() {
+        std::stringstream stream(layout);
+        std::size_t cells = 0;
+        CSVParser::forEachCell(stream, [&](unsigned int, unsigned int, std::string_view) { cells++; });
+        return cells;
+    });
+
+    return 0;
+}
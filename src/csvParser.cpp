@@ -1,47 +1,52 @@
 #include "csvParser.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
-std::string CSVParser::getNextLine(std::istream& is, char delim) {
-    std::string s;
-    
-    for (char c; !is.get(c).eof();)
-        if (c == delim) return s;
-        else s += c;
+CSVParser::CSVParser(std::istream& is, bool columnNamesInFirstRow) {
+    std::ostringstream contents;
+    contents << is.rdbuf();
+    m_buffer = std::move(contents).str();
 
-    return s;
+    index(columnNamesInFirstRow);
 }
 
-std::vector<std::string> CSVParser::splitString(const std::string& s, char delim) {
-    std::vector<std::string> results;
-
-    std::string str;
-    for (auto& c : s) {
-        if (c == delim) {
-            results.push_back(str);
-            str = "";
-        } else str += c;
-    }
+CSVParser::CSVParser(const std::string& filename, bool columnNamesInFirstRow) :
+    m_file(filename),
+    m_mapped(true)
+{
+    index(columnNamesInFirstRow);
+}
 
-    if (str != "") results.push_back(str);
+void CSVParser::index(bool columnNamesInFirstRow) {
+    std::string_view text = data();
+    std::size_t offset = 0;
 
-    return results;
-}
+    if (columnNamesInFirstRow) {
+        std::string_view header = text.substr(0, text.find('\n'));
 
-CSVParser::CSVParser(std::istream& is, bool columnNamesInFirstRow) {
-    if (columnNamesInFirstRow)
-        m_columnNames = splitString(getNextLine(is));
-    
-    while (!is.eof()) {
-        m_rows.push_back(splitString(getNextLine(is)));
+        splitLines(header, [&](std::size_t begin, std::size_t end) {
+            m_columnNames.emplace_back(header.substr(begin, end - begin));
+        }, []() {});
 
-        while (m_rows.back().size() > m_columnNames.size())
-            m_columnNames.push_back("");
+        offset = std::min(header.size() + 1, text.size());
     }
 
-    if (m_rows.size() > 0 && m_rows.back().size() == 0) m_rows.pop_back();
+    // a non-empty cell and its delimiter take at least two characters, so this usually avoids regrowing
+    m_cells.reserve((text.size() - offset) / 2 + 1);
+
+    splitLines(text.substr(offset), [&](std::size_t begin, std::size_t end) {
+        m_cells.push_back({ offset + begin, offset + end });
+    }, [&]() {
+        m_rowStarts.push_back(m_cells.size());
+    });
+
+    for (unsigned int row = 0; row < getRowCount(); row++)
+        while (getRowLength(row) > m_columnNames.size())
+            m_columnNames.push_back("");
 }
 
 unsigned int CSVParser::getColumnCount() const {
@@ -49,7 +54,11 @@ unsigned int CSVParser::getColumnCount() const {
 }
 
 unsigned int CSVParser::getRowCount() const {
-    return m_rows.size();
+    return m_rowStarts.size() - 1;
+}
+
+unsigned int CSVParser::getRowLength(unsigned int row) const {
+    return m_rowStarts[row + 1] - m_rowStarts[row];
 }
 
 unsigned int CSVParser::getColumnIndex(const std::string& name) const {
@@ -64,14 +73,41 @@ const std::vector<std::string>& CSVParser::getColumnNames() const {
     return m_columnNames;
 }
 
-std::vector<std::string>& CSVParser::getRow(unsigned int row) {
-    return m_rows[row];
+std::vector<std::string_view> CSVParser::getRowView(unsigned int row) const {
+    std::vector<std::string_view> cells;
+    cells.reserve(getRowLength(row));
+
+    for (unsigned int column = 0; column < getRowLength(row); column++)
+        cells.push_back(getCellView(row, column));
+
+    return cells;
+}
+
+std::string_view CSVParser::getCellView(unsigned int row, unsigned int column) const {
+    if (column >= getRowLength(row)) return {};
+
+    const CellSpan& cell = m_cells[m_rowStarts[row] + column];
+    return data().substr(cell.begin, cell.end - cell.begin);
+}
+
+std::string_view CSVParser::getCellView(unsigned int row, const std::string& column) const {
+    return getCellView(row, getColumnIndex(column));
+}
+
+std::vector<std::string> CSVParser::getRow(unsigned int row) const {
+    std::vector<std::string> cells;
+    cells.reserve(getRowLength(row));
+
+    for (auto& cell : getRowView(row))
+        cells.emplace_back(cell);
+
+    return cells;
 }
 
-std::string& CSVParser::getCell(unsigned int row, unsigned int column) {
-    return getRow(row)[column];
+std::string CSVParser::getCell(unsigned int row, unsigned int column) const {
+    return std::string { getCellView(row, column) };
 }
 
-std::string& CSVParser::getCell(unsigned int row, const std::string& column) {
-    return getRow(row)[getColumnIndex(column)];
+std::string CSVParser::getCell(unsigned int row, const std::string& column) const {
+    return std::string { getCellView(row, column) };
 }
@@ -0,0 +1,149 @@
+#include <csvScanner.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define CSV_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+#if defined(CSV_SCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CSV_SCANNER_AVX2
+#define CSV_SCANNER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+inline bool isDelimiter(char c) {
+    return c == ',' || c == '\n';
+}
+
+std::size_t findDelimitersScalar(const char* data, std::size_t begin, std::size_t size, std::uint32_t* positions) {
+    std::size_t count = 0;
+
+    // write unconditionally and only advance on a match, so there's no branch to mispredict
+    for (std::size_t i = begin; i < size; i++) {
+        positions[count] = static_cast<std::uint32_t>(i);
+        count += isDelimiter(data[i]);
+    }
+
+    return count;
+}
+
+// emit the offset of every set bit in mask, lowest bit first
+inline std::size_t emitMask(std::uint32_t mask, std::size_t base, std::uint32_t* positions) {
+    std::size_t count = 0;
+
+    while (mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        positions[count++] = static_cast<std::uint32_t>(base + __builtin_ctz(mask));
+#else
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        positions[count++] = static_cast<std::uint32_t>(base + bit);
+#endif
+        mask &= mask - 1;
+    }
+
+    return count;
+}
+
+#ifdef CSV_SCANNER_X86
+
+std::size_t findDelimitersSSE2(const char* data, std::size_t size, std::uint32_t* positions) {
+    const __m128i commas = _mm_set1_epi8(',');
+    const __m128i newlines = _mm_set1_epi8('\n');
+
+    std::size_t count = 0;
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(block, commas), _mm_cmpeq_epi8(block, newlines));
+
+        count += emitMask(static_cast<std::uint32_t>(_mm_movemask_epi8(matches)), i, positions + count);
+    }
+
+    return count + findDelimitersScalar(data, i, size, positions + count);
+}
+
+#endif
+
+#ifdef CSV_SCANNER_AVX2
+
+CSV_SCANNER_TARGET_AVX2
+std::size_t findDelimitersAVX2(const char* data, std::size_t size, std::uint32_t* positions) {
+    const __m256i commas = _mm256_set1_epi8(',');
+    const __m256i newlines = _mm256_set1_epi8('\n');
+
+    std::size_t count = 0;
+    std::size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(block, commas), _mm256_cmpeq_epi8(block, newlines));
+
+        count += emitMask(static_cast<std::uint32_t>(_mm256_movemask_epi8(matches)), i, positions + count);
+    }
+
+    return count + findDelimitersScalar(data, i, size, positions + count);
+}
+
+#endif
+
+CSVScanner::Implementation detectBestImplementation() {
+#ifdef CSV_SCANNER_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return CSVScanner::Implementation::AVX2;
+#endif
+
+#ifdef CSV_SCANNER_X86
+    return CSVScanner::Implementation::SSE2;
+#else
+    return CSVScanner::Implementation::Scalar;
+#endif
+}
+
+}
+
+bool CSVScanner::isSupported(Implementation implementation) {
+    static const Implementation best = detectBestImplementation();
+
+    switch (implementation) {
+    case Implementation::Scalar : return true;
+    case Implementation::SSE2   : return best == Implementation::SSE2 || best == Implementation::AVX2;
+    case Implementation::AVX2   : return best == Implementation::AVX2;
+    case Implementation::Best   : return true;
+    default                     : return false;
+    }
+}
+
+const char* CSVScanner::getName(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::Scalar : return "scalar";
+    case Implementation::SSE2   : return "SSE2";
+    case Implementation::AVX2   : return "AVX2";
+    case Implementation::Best   : return "best";
+    default                     : return "unknown";
+    }
+}
+
+std::size_t CSVScanner::findDelimiters(
+    const char* data,
+    std::size_t size,
+    std::uint32_t* positions,
+    Implementation implementation
+) {
+    static const Implementation best = detectBestImplementation();
+
+    if (implementation == Implementation::Best || !isSupported(implementation))
+        implementation = best;
+
+    switch (implementation) {
+#ifdef CSV_SCANNER_AVX2
+    case Implementation::AVX2: return findDelimitersAVX2(data, size, positions);
+#endif
+#ifdef CSV_SCANNER_X86
+    case Implementation::SSE2: return findDelimitersSSE2(data, size, positions);
+#endif
+    default: return findDelimitersScalar(data, 0, size, positions);
+    }
+}
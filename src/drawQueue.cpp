@@ -0,0 +1,69 @@
+#include <drawQueue.hpp>
+
+#include <array>
+#include <bit>
+
+std::uint32_t DrawQueue::toOrderable(float value) {
+    std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+
+    // negative floats order backwards, so flip all their bits, positive ones just need the sign bit set
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+void DrawQueue::clear() {
+    m_entries.clear();
+    m_items.clear();
+}
+
+void DrawQueue::submit(std::uint32_t layer, float depth, const sf::Sprite& sprite) {
+    std::uint64_t key = static_cast<std::uint64_t>(layer) << 32 | toOrderable(depth);
+
+    m_entries.push_back({ key, static_cast<std::uint32_t>(m_items.size()) });
+    m_items.push_back({ sprite.getTexture(), sprite.getTextureRect(), sprite.getTransform(), sprite.getColor() });
+}
+
+void DrawQueue::sort() {
+    static constexpr int s_passes = sizeof(std::uint64_t);
+
+    std::size_t count = m_entries.size();
+    if (count < 2) return;
+
+    // every pass's histogram comes from the same single read of the keys
+    std::array<std::array<std::uint32_t, 256>, s_passes> histograms {};
+
+    for (auto& entry : m_entries)
+    for (int pass = 0; pass < s_passes; pass++)
+        histograms[pass][(entry.m_key >> (pass * 8)) & 0xff]++;
+
+    m_sortBuffer.resize(count);
+
+    for (int pass = 0; pass < s_passes; pass++) {
+        auto& histogram = histograms[pass];
+        int shift = pass * 8;
+
+        // most passes are over bytes every key shares, such as the unused high bytes of the layer
+        if (histogram[(m_entries.front().m_key >> shift) & 0xff] == count) continue;
+
+        std::array<std::uint32_t, 256> offsets;
+        std::uint32_t offset = 0;
+
+        for (int byte = 0; byte < 256; byte++) {
+            offsets[byte] = offset;
+            offset += histogram[byte];
+        }
+
+        for (auto& entry : m_entries)
+            m_sortBuffer[offsets[(entry.m_key >> shift) & 0xff]++] = entry;
+
+        std::swap(m_entries, m_sortBuffer);
+    }
+}
+
+void DrawQueue::emit(SpriteBatch& batch) {
+    sort();
+
+    for (auto& entry : m_entries) {
+        const Item& item = m_items[entry.m_item];
+        batch.add(item.r_texture, item.m_textureRect, item.m_transform, item.m_color);
+    }
+}
@@ -0,0 +1,156 @@
+#include <flowField.hpp>
+
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace {
+
+struct Neighbour {
+    sf::Vector2i m_offset;
+    std::uint32_t m_cost;
+};
+
+}
+
+bool FlowField::update(const TileSet& tileSet, sf::Vector2f target) {
+    m_target = target;
+
+    sf::Vector2i targetCell {
+        static_cast<int>(std::floor(target.x / tileSet.getCellSize().x)),
+        static_cast<int>(std::floor(target.y / tileSet.getCellSize().y))
+    };
+
+    if (targetCell == m_targetCell && tileSet.getSolidityVersion() == m_solidityVersion)
+        return false;
+
+    m_targetCell = targetCell;
+    m_solidityVersion = tileSet.getSolidityVersion();
+    rebuild(tileSet);
+
+    return true;
+}
+
+void FlowField::rebuild(const TileSet& tileSet) {
+    m_cellSize = tileSet.getCellSize();
+    m_gridColumns = tileSet.gridColumns();
+    m_gridRows = tileSet.gridRows();
+
+    std::size_t cellCount = static_cast<std::size_t>(m_gridColumns) * m_gridRows;
+    m_distances.assign(cellCount, s_unreachable);
+    m_directions.assign(cellCount, {});
+
+    auto isOpen = [&](const sf::Vector2i& cell) {
+        return cell.x >= 0 && cell.y >= 0 && cell.x < m_gridColumns && cell.y < m_gridRows && !tileSet.isSolid(cell);
+    };
+
+    if (!isOpen(m_targetCell)) return;
+
+    static const Neighbour neighbours[8] = {
+        { {  1,  0 }, s_straightCost }, { { -1,  0 }, s_straightCost },
+        { {  0,  1 }, s_straightCost }, { {  0, -1 }, s_straightCost },
+        { {  1,  1 }, s_diagonalCost }, { { -1,  1 }, s_diagonalCost },
+        { {  1, -1 }, s_diagonalCost }, { { -1, -1 }, s_diagonalCost },
+    };
+
+    // moving diagonally past the corner of a wall would snag on it
+    auto canStep = [&](const sf::Vector2i& cell, const sf::Vector2i& offset) {
+        sf::Vector2i next = cell + offset;
+        if (!isOpen(next)) return false;
+        if (offset.x == 0 || offset.y == 0) return true;
+        return isOpen({ next.x, cell.y }) && isOpen({ cell.x, next.y });
+    };
+
+    auto index = [&](const sf::Vector2i& cell) {
+        return cell.x + cell.y * m_gridColumns;
+    };
+
+    using QueueEntry = std::pair<std::uint32_t, int>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> queue;
+
+    m_distances[index(m_targetCell)] = 0;
+    queue.push({ 0, index(m_targetCell) });
+
+    while (!queue.empty()) {
+        auto [distance, cellIndex] = queue.top();
+        queue.pop();
+
+        if (distance > m_distances[cellIndex]) continue;
+
+        sf::Vector2i cell { cellIndex % m_gridColumns, cellIndex / m_gridColumns };
+
+        for (auto& neighbour : neighbours) {
+            if (!canStep(cell, neighbour.m_offset)) continue;
+
+            int neighbourIndex = index(cell + neighbour.m_offset);
+            std::uint32_t neighbourDistance = distance + neighbour.m_cost;
+
+            if (neighbourDistance < m_distances[neighbourIndex]) {
+                m_distances[neighbourIndex] = neighbourDistance;
+                queue.push({ neighbourDistance, neighbourIndex });
+            }
+        }
+    }
+
+    auto getUnitOffset = [](const Neighbour& neighbour) {
+        sf::Vector2f offset { neighbour.m_offset };
+        return offset / std::sqrt(offset.x * offset.x + offset.y * offset.y);
+    };
+
+    // head down the steepest step, blended with the steps either side of it by how steep they
+    // are, so open ground gets directions between the eight neighbours rather than a zigzag.
+    // Steps further round aren't blended in, or two equally good ways round a wall would cancel.
+    sf::Vector2i cell;
+    for (cell.y = 0; cell.y < m_gridRows; cell.y++)
+    for (cell.x = 0; cell.x < m_gridColumns; cell.x++) {
+        std::uint32_t distance = m_distances[index(cell)];
+        if (!isReachable(distance) || distance <= s_diagonalCost) continue;
+
+        float slopes[8] = {};
+        int steepest = -1;
+
+        for (int i = 0; i < 8; i++) {
+            if (!canStep(cell, neighbours[i].m_offset)) continue;
+
+            std::uint32_t neighbourDistance = m_distances[index(cell + neighbours[i].m_offset)];
+            if (neighbourDistance >= distance) continue;
+
+            slopes[i] = static_cast<float>(distance - neighbourDistance) / neighbours[i].m_cost;
+            if (steepest < 0 || slopes[i] > slopes[steepest]) steepest = i;
+        }
+
+        if (steepest < 0) continue;
+
+        sf::Vector2f steepestOffset = getUnitOffset(neighbours[steepest]);
+        sf::Vector2f direction;
+
+        for (int i = 0; i < 8; i++) {
+            sf::Vector2f offset = getUnitOffset(neighbours[i]);
+
+            // within 45 degrees of the steepest step
+            if (offset.x * steepestOffset.x + offset.y * steepestOffset.y > 0.7f)
+                direction += offset * slopes[i];
+        }
+
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        m_directions[index(cell)] = direction / length;
+    }
+}
+
+sf::Vector2f FlowField::getDirection(sf::Vector2f position) const {
+    sf::Vector2f gridPosition { position.x / m_cellSize.x, position.y / m_cellSize.y };
+
+    // compared as floats, so positions far off the grid never overflow a cell index
+    if (!m_directions.empty()
+     && gridPosition.x >= 0.f && gridPosition.x < m_gridColumns
+     && gridPosition.y >= 0.f && gridPosition.y < m_gridRows) {
+        sf::Vector2f direction = m_directions[static_cast<int>(gridPosition.x) + static_cast<int>(gridPosition.y) * m_gridColumns];
+        if (direction.x != 0.f || direction.y != 0.f) return direction;
+    }
+
+    sf::Vector2f diff = m_target - position;
+    float length = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+
+    return length > 0.f ? diff / length : sf::Vector2f {};
+}
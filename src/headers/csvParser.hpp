@@ -1,27 +1,224 @@
 #pragma once
 
+#include <mappedFile.hpp>
+#include <csvScanner.hpp>
+
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <system_error>
+#include <span>
+#include <cstddef>
+#include <cstdint>
 
+// Cells are stored as offsets into a single character buffer, which is either
+// the memory-mapped file or a copy of the stream's contents. Rows may have
+// different numbers of cells.
 class CSVParser {
+    struct CellSpan {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    MappedFile m_file;
+    std::string m_buffer;
+    bool m_mapped = false;
+
     std::vector<std::string> m_columnNames;
-    std::vector<std::vector<std::string>> m_rows;
+    std::vector<CellSpan> m_cells;
+    std::vector<std::size_t> m_rowStarts { 0 };
+
+    std::string_view data() const { return m_mapped ? m_file.view() : std::string_view { m_buffer }; }
+
+    void index(bool columnNamesInFirstRow);
+
+    static constexpr std::size_t s_streamChunkSize = 1 << 16;
+    static constexpr std::size_t s_scanBlockSize = 1 << 12;
+
+    // Reads the stream a chunk at a time and splits each run of complete lines with splitLines.
+    // Only the current chunk and any line that straddles two chunks are held in memory, and
+    // text is only valid until the visitors return.
+    template <typename CellVisitor, typename LineVisitor>
+    static void streamLines(std::istream& is, CellVisitor&& onCell, LineVisitor&& onLineEnd) {
+        std::vector<char> buffer(s_streamChunkSize);
+        std::size_t carried = 0;
+
+        while (is) {
+            if (carried == buffer.size()) buffer.resize(buffer.size() * 2);
+
+            is.read(buffer.data() + carried, buffer.size() - carried);
+            std::size_t available = carried + is.gcount();
+
+            std::string_view text { buffer.data(), available };
+            std::size_t lineEnd = text.rfind('\n');
+            std::size_t complete = lineEnd == std::string_view::npos ? 0 : lineEnd + 1;
 
-    static std::string getNextLine(std::istream& is, char delim = '\n');
-    static std::vector<std::string> splitString(const std::string& s, char delim = ',');
+            splitLines(text.substr(0, complete), [&](std::size_t begin, std::size_t end) {
+                onCell(text.substr(begin, end - begin));
+            }, onLineEnd);
+
+            carried = available - complete;
+            std::copy(buffer.begin() + complete, buffer.begin() + available, buffer.begin());
+        }
+
+        std::string_view lastLine { buffer.data(), carried };
+        splitLines(lastLine, [&](std::size_t begin, std::size_t end) {
+            onCell(lastLine.substr(begin, end - begin));
+        }, onLineEnd);
+    }
 
 public:
+    struct CellError {
+        unsigned int row;
+        unsigned int column;
+        std::errc error;
+    };
+
     CSVParser() = default;
     CSVParser(std::istream& is, bool columnNamesInFirstRow = true);
 
+    // Memory-maps the file, cells are only copied when requested through getCell/getRow
+    CSVParser(const std::string& filename, bool columnNamesInFirstRow = true);
+
     unsigned int getColumnCount() const;
     unsigned int getRowCount() const;
+    unsigned int getRowLength(unsigned int row) const;
     unsigned int getColumnIndex(const std::string& name) const;
 
     const std::vector<std::string>& getColumnNames() const;
 
-    std::vector<std::string>& getRow(unsigned int row);
-    std::string& getCell(unsigned int row, unsigned int column);
-    std::string& getCell(unsigned int row, const std::string& columnName);
+    std::vector<std::string_view> getRowView(unsigned int row) const;
+    std::string_view getCellView(unsigned int row, unsigned int column) const;
+    std::string_view getCellView(unsigned int row, const std::string& columnName) const;
+
+    std::vector<std::string> getRow(unsigned int row) const;
+    std::string getCell(unsigned int row, unsigned int column) const;
+    std::string getCell(unsigned int row, const std::string& columnName) const;
+
+    // Parses the whole of a cell as a number with std::from_chars. If the cell isn't
+    // entirely a number, error is set and T {} is returned.
+    template <typename T>
+    static T parseCell(std::string_view cell, std::errc& error) {
+        T value {};
+        auto [end, result] = std::from_chars(cell.data(), cell.data() + cell.size(), value);
+
+        error = result == std::errc {} && end != cell.data() + cell.size()
+              ? std::errc::invalid_argument
+              : result;
+
+        return error == std::errc {} ? value : T {};
+    }
+
+    template <typename T>
+    static T parseCell(std::string_view cell) {
+        std::errc error;
+        return parseCell<T>(cell, error);
+    }
+
+    // Bulk numeric accessors. Cells that fail to parse, including cells missing from short
+    // rows, are left as T {} and reported in errors if it is given.
+    template <typename T>
+    std::vector<T> getRowAs(unsigned int row, std::vector<CellError>* errors = nullptr) const {
+        std::vector<T> values(getRowLength(row));
+        parseCells(row, 0, values.size(), values.data(), errors);
+        return values;
+    }
+
+    template <typename T>
+    std::vector<T> getColumnAs(unsigned int column, std::vector<CellError>* errors = nullptr) const {
+        std::vector<T> values(getRowCount());
+
+        for (unsigned int row = 0; row < getRowCount(); row++)
+            parseCells(row, column, 1, values.data() + row, errors);
+
+        return values;
+    }
+
+    // Row major, getColumnCount() values per row
+    template <typename T>
+    std::vector<T> getTableAs(std::vector<CellError>* errors = nullptr) const {
+        std::vector<T> values(static_cast<std::size_t>(getRowCount()) * getColumnCount());
+
+        for (unsigned int row = 0; row < getRowCount(); row++)
+            parseCells(row, 0, getColumnCount(), values.data() + static_cast<std::size_t>(row) * getColumnCount(), errors);
+
+        return values;
+    }
+
+    // Splits text into lines and cells, calling onCell(begin, end) with the offsets of each cell and
+    // onLineEnd() after the last cell of each line. The end of text finishes a line that has no newline.
+    // A trailing empty cell is not reported, so neither is anything for an empty line.
+    template <typename CellVisitor, typename LineVisitor>
+    static void splitLines(std::string_view text, CellVisitor&& onCell, LineVisitor&& onLineEnd) {
+        std::uint32_t positions[s_scanBlockSize];
+        std::size_t cellStart = 0;
+
+        for (std::size_t blockStart = 0; blockStart < text.size(); blockStart += s_scanBlockSize) {
+            std::size_t blockSize = std::min(s_scanBlockSize, text.size() - blockStart);
+            std::size_t count = CSVScanner::findDelimiters(text.data() + blockStart, blockSize, positions);
+
+            for (std::size_t k = 0; k < count; k++) {
+                std::size_t i = blockStart + positions[k];
+
+                if (text[i] == ',') onCell(cellStart, i);
+                else {
+                    if (cellStart != i) onCell(cellStart, i);
+                    onLineEnd();
+                }
+
+                cellStart = i + 1;
+            }
+        }
+
+        if (!text.empty() && text.back() != '\n') {
+            if (cellStart != text.size()) onCell(cellStart, text.size());
+            onLineEnd();
+        }
+    }
+
+    // Streaming alternatives to building a table, the visitor is called as
+    // visitor(row, column, cell) for every cell in the order they are read.
+    template <typename CellVisitor>
+    static void forEachCell(std::istream& is, CellVisitor&& visitor) {
+        unsigned int row = 0, column = 0;
+
+        streamLines(is, [&](std::string_view cell) {
+            visitor(row, column++, cell);
+        }, [&]() {
+            row++;
+            column = 0;
+        });
+    }
+
+    // As forEachCell, but the visitor is called once per row as visitor(row, cells).
+    // The cells are only valid until the visitor returns.
+    template <typename RowVisitor>
+    static void forEachRow(std::istream& is, RowVisitor&& visitor) {
+        std::vector<std::string_view> cells;
+        unsigned int row = 0;
+
+        streamLines(is, [&](std::string_view cell) {
+            cells.push_back(cell);
+        }, [&]() {
+            visitor(row++, std::span<const std::string_view> { cells });
+            cells.clear();
+        });
+    }
+
+private:
+    template <typename T>
+    void parseCells(unsigned int row, unsigned int firstColumn, std::size_t count, T* values, std::vector<CellError>* errors) const {
+        for (std::size_t i = 0; i < count; i++) {
+            unsigned int column = firstColumn + i;
+
+            std::errc error;
+            values[i] = parseCell<T>(getCellView(row, column), error);
+
+            if (error != std::errc {} && errors)
+                errors->push_back({ row, column, error });
+        }
+    }
 };
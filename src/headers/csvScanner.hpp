@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorised search for the ',' and '\n' characters that separate CSV cells.
+class CSVScanner {
+public:
+    enum class Implementation {
+        Scalar,
+        SSE2,
+        AVX2,
+        Best,
+    };
+
+    static bool isSupported(Implementation implementation);
+    static const char* getName(Implementation implementation);
+
+    // Writes the offset of every delimiter in data to positions, in order, and returns how many there were.
+    // positions must have room for size entries.
+    static std::size_t findDelimiters(
+        const char* data,
+        std::size_t size,
+        std::uint32_t* positions,
+        Implementation implementation = Implementation::Best);
+};
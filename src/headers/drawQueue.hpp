@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <spriteBatch.hpp>
+
+#include <cstdint>
+#include <vector>
+
+enum DrawLayer : std::uint32_t {
+    e_GroundLayer = 0,
+    e_CharacterLayer,
+    e_OverlayLayer,
+};
+
+// Sprites are submitted in any order with a layer and a depth, then emitted to a sprite batch
+// sorted by layer and then depth, so characters further down the screen are drawn over those
+// behind them. Sprites with equal keys keep the order they were submitted in.
+class DrawQueue {
+    struct Entry {
+        // the layer in the high 32 bits, the depth as an orderable float in the low 32 bits
+        std::uint64_t m_key;
+        std::uint32_t m_item;
+    };
+
+    struct Item {
+        const sf::Texture* r_texture;
+        sf::IntRect m_textureRect;
+        sf::Transform m_transform;
+        sf::Color m_color;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_sortBuffer;
+    std::vector<Item> m_items;
+
+public:
+    // Maps a float onto an unsigned integer with the same ordering, negative numbers included
+    static std::uint32_t toOrderable(float value);
+
+    void clear();
+    void submit(std::uint32_t layer, float depth, const sf::Sprite& sprite);
+
+    // Least significant byte first radix sort, which is stable and linear in the number of sprites.
+    // Called by emit, and by the benchmark to check it against std::stable_sort.
+    void sort();
+
+    // Sorts everything submitted and adds it to the batch in order
+    void emit(SpriteBatch& batch);
+
+    std::size_t size() const { return m_entries.size(); }
+    // Which submission, counting from 0, is at index once sorted
+    std::uint32_t getSubmissionAt(std::size_t index) const { return m_entries[index].m_item; }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <tileSet.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// The way to a target from every cell of a tile set, shared by everything heading for it. Built
+// from a distance map that walks around walls, so following it never runs into a dead end.
+// Only rebuilt when the target moves to another cell or the walls change, and looking up a
+// direction doesn't depend on how many things are following it.
+class FlowField {
+    static constexpr std::uint32_t s_unreachable = std::numeric_limits<std::uint32_t>::max();
+    // steps between cells, in tenths of a cell, so diagonals cost about their real length
+    static constexpr std::uint32_t s_straightCost = 10;
+    static constexpr std::uint32_t s_diagonalCost = 14;
+
+    int m_gridColumns = 0;
+    int m_gridRows = 0;
+    sf::Vector2f m_cellSize;
+
+    sf::Vector2f m_target;
+    sf::Vector2i m_targetCell { -1, -1 };
+    std::uint32_t m_solidityVersion = 0;
+
+    std::vector<std::uint32_t> m_distances;
+    // unit directions, zero where heading straight for the target is best
+    std::vector<sf::Vector2f> m_directions;
+
+    void rebuild(const TileSet& tileSet);
+
+public:
+    // Returns whether the field had to be rebuilt
+    bool update(const TileSet& tileSet, sf::Vector2f target);
+
+    // Which way to go from position, cells next to the target, cells cut off from it and
+    // anywhere off the grid head straight for the target
+    sf::Vector2f getDirection(sf::Vector2f position) const;
+
+    // In tenths of a cell, or s_unreachable
+    std::uint32_t getDistance(const sf::Vector2i& cell) const {
+        return m_distances[cell.x + cell.y * m_gridColumns];
+    }
+
+    static bool isReachable(std::uint32_t distance) { return distance != s_unreachable; }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <tileSet.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// Point to point paths over a tile set, for maps too big to search cell by cell. The grid is split
+// into square clusters and the open cells either side of each cluster border become entrances.
+// A query searches a small graph of entrances, with the costs across each cluster worked out
+// ahead of time, and only walks the cells of the clusters it passes through.
+//
+// Paths move between the eight neighbouring cells without cutting wall corners, like FlowField,
+// and are close to but not always exactly the shortest.
+class HierarchicalPathfinder {
+public:
+    static constexpr int s_clusterSize = 16;
+
+    using RequestId = std::uint32_t;
+
+private:
+    static constexpr std::uint32_t s_unreachable = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t s_straightCost = 10;
+    static constexpr std::uint32_t s_diagonalCost = 14;
+
+    struct Edge {
+        int m_target;
+        std::uint32_t m_cost;
+        // across a cluster, rather than over a border between two
+        bool m_intra;
+        // the cells after the source up to and including the target, found the first time a path uses the edge
+        std::vector<sf::Vector2i> m_path;
+    };
+
+    struct Node {
+        sf::Vector2i m_cell;
+        int m_cluster = -1;
+        // how many border entrances use this cell, the node is freed when none do
+        int m_entranceCount = 0;
+        std::vector<Edge> m_edges;
+    };
+
+    // Dijkstra over the cells of one cluster
+    struct LocalSearch {
+        sf::IntRect m_bounds;
+        std::vector<std::uint32_t> m_distances;
+        std::vector<int> m_parents;
+
+        void run(const TileSet& tileSet, const sf::IntRect& bounds, const sf::Vector2i& start);
+
+        std::uint32_t getDistance(const sf::Vector2i& cell) const;
+        // The cells after the start up to and including cell
+        std::vector<sf::Vector2i> getPathTo(const sf::Vector2i& cell) const;
+    };
+
+    struct Request {
+        RequestId m_id;
+        sf::Vector2i m_start;
+        sf::Vector2i m_goal;
+    };
+
+    int m_gridColumns = 0;
+    int m_gridRows = 0;
+    int m_clusterColumns = 0;
+    int m_clusterRows = 0;
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+    std::unordered_map<int, int> m_nodeAtCell;
+    std::vector<std::vector<int>> m_clusterNodes;
+    // the pairs of nodes facing each other across each border, two borders per cluster, the one
+    // on its right and the one below it
+    std::vector<std::vector<std::pair<int, int>>> m_borderEntrances;
+
+    std::vector<sf::Vector2i> m_dirtyCells;
+    // whether each cell was a wall when the graph was last brought up to date, so update can
+    // tell which invalidated cells really changed
+    std::vector<std::uint8_t> m_solid;
+    std::uint32_t m_solidityRebuildVersion = 0;
+    std::uint32_t m_solidCellChangeCount = 0;
+    bool m_built = false;
+
+    std::deque<Request> m_requests;
+    std::unordered_map<RequestId, std::vector<sf::Vector2i>> m_results;
+    RequestId m_nextRequestId = 0;
+
+    static bool isOpen(const TileSet& tileSet, const sf::IntRect& bounds, const sf::Vector2i& cell);
+    static bool canStep(const TileSet& tileSet, const sf::IntRect& bounds, const sf::Vector2i& cell, const sf::Vector2i& offset);
+    static std::uint32_t estimateCost(const sf::Vector2i& from, const sf::Vector2i& to);
+
+    int getCluster(const sf::Vector2i& cell) const {
+        return cell.x / s_clusterSize + cell.y / s_clusterSize * m_clusterColumns;
+    }
+
+    sf::IntRect getClusterBounds(int cluster) const;
+
+    int acquireNode(const sf::Vector2i& cell);
+    void releaseNode(int node);
+
+    void rebuild(const TileSet& tileSet);
+    void rebuildBorder(const TileSet& tileSet, int cluster, bool below);
+    void rebuildClusterEdges(const TileSet& tileSet, int cluster);
+
+    const std::vector<sf::Vector2i>& getEdgePath(const TileSet& tileSet, int source, Edge& edge);
+
+public:
+    // Brings the graph up to date with the tile set. Clusters with cells passed to invalidateCell
+    // are rebuilt along with their neighbours. Any other change to the walls, such as a wall type
+    // added or a cell changed without being invalidated, rebuilds everything, and then this
+    // returns true.
+    bool update(const TileSet& tileSet);
+    // Call for every cell whose wall changes, so the graph only has to be rebuilt around it
+    void invalidateCell(const sf::Vector2i& cell);
+
+    // The cells from start to goal, both included, or nothing if there's no way there
+    std::vector<sf::Vector2i> findPath(const TileSet& tileSet, const sf::Vector2i& start, const sf::Vector2i& goal);
+
+    // Queues a query, to be answered by processRequests
+    RequestId requestPath(const sf::Vector2i& start, const sf::Vector2i& goal);
+    // Brings the graph up to date, then answers queued queries until the budget is spent, always
+    // at least one unless rebuilding the whole graph spent the budget first
+    void processRequests(const TileSet& tileSet, sf::Time budget);
+    std::size_t getPendingRequestCount() const { return m_requests.size(); }
+    // The answer to a request once it's been processed, which is then forgotten
+    std::optional<std::vector<sf::Vector2i>> takePath(RequestId id);
+
+    std::size_t getNodeCount() const { return m_nodes.size() - m_freeNodes.size(); }
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The player's input for every tick of a run, with the simulation's state hash after each one,
+// so replaying it can check every tick comes out exactly the same
+class InputRecording {
+    std::vector<std::uint8_t> m_inputs;
+    std::vector<std::uint64_t> m_stateHashes;
+    // Simulation::getLevelHash of the level it was recorded on
+    std::uint64_t m_levelHash = 0;
+
+public:
+    InputRecording() = default;
+    explicit InputRecording(std::uint64_t levelHash) : m_levelHash(levelHash) {}
+
+    void record(std::uint8_t input, std::uint64_t stateHash) {
+        m_inputs.push_back(input);
+        m_stateHashes.push_back(stateHash);
+    }
+
+    std::size_t getTickCount() const { return m_inputs.size(); }
+    std::uint8_t getInput(std::size_t tick) const { return m_inputs[tick]; }
+    std::uint64_t getStateHash(std::size_t tick) const { return m_stateHashes[tick]; }
+    std::uint64_t getLevelHash() const { return m_levelHash; }
+
+    // Throws if it was recorded on a level with a different hash, before any of it is replayed
+    static InputRecording loadFromFile(const std::string& filename, std::uint64_t levelHash);
+    void saveToFile(const std::string& filename) const;
+
+    // Whether the file starts like a recording
+    static bool isRecording(const std::string& filename);
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A pool of worker threads that split loops between them. Each worker has its own queue of
+// ranges and takes work from the back of it, when it runs out it steals from the front of the
+// others'. The thread that starts a loop works through the queues too until the loop is done.
+class JobSystem {
+    // A loop's task behind a plain function pointer, so starting a loop never allocates
+    using TaskFunction = void (*)(void* task, std::size_t begin, std::size_t end);
+
+    struct Batch {
+        TaskFunction r_function;
+        void* r_task;
+        std::atomic<std::size_t> m_remaining = 0;
+        std::mutex m_errorMutex;
+        std::exception_ptr m_error;
+    };
+
+    struct Job {
+        Batch* r_batch;
+        std::size_t m_begin;
+        std::size_t m_end;
+    };
+
+    struct alignas(64) Queue {
+        std::mutex m_mutex;
+        std::deque<Job> m_jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::once_flag m_started;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<std::size_t> m_queuedJobs = 0;
+    bool m_stopping = false;
+
+    static JobSystem s_singleton;
+    static thread_local unsigned int s_workerIndex;
+
+    JobSystem() = default;
+
+    void start();
+    void workerLoop(unsigned int workerIndex);
+    bool tryRunJob(unsigned int workerIndex);
+    void run(std::size_t count, std::size_t minimumRange, TaskFunction function, void* task);
+
+public:
+    JobSystem(const JobSystem& other) = delete;
+    JobSystem(JobSystem&& other) = delete;
+    JobSystem& operator=(const JobSystem& other) = delete;
+    JobSystem& operator=(JobSystem&& other) = delete;
+
+    ~JobSystem();
+
+    static JobSystem& get();
+
+    // The calling thread counts as one, so this is the number of ranges that run at once
+    static unsigned int getThreadCount() { return std::max(1u, std::thread::hardware_concurrency()); }
+    // Workers are numbered from 1, any thread outside the pool is 0
+    static unsigned int getWorkerIndex() { return s_workerIndex; }
+
+    // Calls task(begin, end) over ranges covering [0, count), each at least minimumRange long
+    // apart from the last, and returns once they've all finished. Rethrows the first exception
+    // any range threw. Small loops just run on the calling thread.
+    template<typename Task>
+    void parallelFor(std::size_t count, std::size_t minimumRange, Task&& task) {
+        using TaskType = std::remove_reference_t<Task>;
+
+        run(count, minimumRange, [](void* task, std::size_t begin, std::size_t end) {
+            (*static_cast<TaskType*>(task))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(std::addressof(task))));
+    }
+};
+
+// Side effects from inside a parallelFor that have to happen on one thread, like playing sounds
+// or removing entities. Each thread pushes onto its own buffer, and the buffers are all drained
+// on the calling thread once the loop is done.
+template<typename Command>
+class CommandBuffers {
+    struct alignas(64) Buffer {
+        std::vector<Command> m_commands;
+    };
+
+    std::vector<Buffer> m_buffers = std::vector<Buffer>(JobSystem::getThreadCount());
+
+public:
+    void push(Command command) {
+        m_buffers[JobSystem::getWorkerIndex()].m_commands.push_back(std::move(command));
+    }
+
+    bool empty() const {
+        return std::all_of(m_buffers.begin(), m_buffers.end(), [](const Buffer& buffer) { return buffer.m_commands.empty(); });
+    }
+
+    // Calls f with every command, a thread's commands in the order it pushed them
+    template<typename F>
+    void flush(F&& f) {
+        for (auto& buffer : m_buffers) {
+            for (auto& command : buffer.m_commands) f(command);
+            buffer.m_commands.clear();
+        }
+    }
+};
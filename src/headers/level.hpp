@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <tileLayout.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum ObjectType : int {
+    e_None = 0,
+    e_Player,
+    e_Orc,
+};
+
+ObjectType parseObject(std::string_view name);
+
+// Everything needed to start a level: its tile set, its map layout and where the characters spawn.
+// Levels are written as csv files by the level editor, and can be compiled by levelCompiler into a
+// binary file next to the csv, which is much faster to load.
+struct Level {
+    struct Spawn {
+        ObjectType m_type;
+        sf::Vector2f m_position;
+    };
+
+    std::string m_tileSetPath;
+    int m_tileSetColumns = 0;
+    int m_tileSetRows = 0;
+    float m_mapScale = 1.f;
+    std::string m_mapFilePath;
+
+    // Empty when the map is a paged world
+    TileLayout m_layout;
+    std::vector<Spawn> m_spawns;
+
+    // Maps with a .world extension are paged worlds written by levelCompiler --paged. They're too big
+    // to load whole, so the simulation streams them from disk instead.
+    bool isPaged() const;
+
+    // The first row is the tile set path, its columns and rows, the map scale and the map layout path,
+    // every other row is an object name and its x and y position
+    static Level loadFromCSV(const std::string& filename);
+    static Level loadFromBinary(const std::string& filename);
+
+    // Prefers the compiled binary next to the csv file when there is one
+    static Level load(const std::string& csvFilename);
+    static std::string getBinaryPath(const std::string& csvFilename);
+
+    void saveToBinary(const std::string& filename) const;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Read-only view of a whole file. On POSIX systems the file is memory-mapped,
+// elsewhere it is read into an owned buffer.
+class MappedFile {
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+
+#ifdef _WIN32
+    std::string m_buffer;
+#endif
+
+    void unmap();
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    std::string_view view() const { return { m_data, m_size }; }
+};
@@ -1,24 +1,43 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
 
-#include <soundManager.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <flowField.hpp>
+#include <jobSystem.hpp>
+#include <player.hpp>
+#include <soundQueue.hpp>
+#include <snapshot.hpp>
+#include <spatialHash.hpp>
 #include <spriteSheet.hpp>
+#include <steeringKernel.hpp>
 #include <tileSet.hpp>
-
-class Orc {
+#include <textureAtlas.hpp>
+
+enum OrcAnimation : int {
+    e_OrcIdle = 0,
+    e_OrcWalk,
+    e_OrcDamage,
+    e_OrcAttack,
+    e_OrcAnimationCount
+};
+
+// Every orc in the level, kept as parallel arrays so each update only walks the components it
+// needs. Orcs are indices into the arrays and removing one moves the last orc into its place.
+class OrcStore {
     class Resources {
         static Resources s_singleton;
 
-        sf::Texture m_idleSpriteSheetTexture,
-                    m_walkSpriteSheetTexture,
-                    m_damageSpriteSheetTexture,
-                    m_attackSpriteSheetTexture;
+        const TextureAtlas::Region *r_idleSpriteSheet,
+                                   *r_walkSpriteSheet,
+                                   *r_damageSpriteSheet,
+                                   *r_attackSpriteSheet;
 
-        sf::SoundBuffer *r_attackSound,
-                        *r_stepSound,
-                        *r_damageSound;
+        // Shared by every orc, each orc only keeps its own animation indices
+        SpriteSheet m_spriteSheets[e_OrcAnimationCount];
 
         bool m_loaded = false;
 
@@ -27,90 +46,149 @@ class Orc {
         static constexpr char s_damageSpriteSheetPath[] = "../assets/sprites/Minifantasy_Dungeon_v2.2_Free_Version/Minifantasy_Dungeon_Assets/Characters/Orc/Dmg.png";
         static constexpr char s_attackSpriteSheetPath[] = "../assets/sprites/Minifantasy_Dungeon_v2.2_Free_Version/Minifantasy_Dungeon_Assets/Characters/Orc/Attack.png";
 
-        static constexpr char s_attackSoundPath[] = "../assets/audio/Minifantasy_Dungeon_SFX/17_orc_atk_sword_1.wav";
-        static constexpr char s_walkSoundPath[] = "../assets/audio/Minifantasy_Dungeon_SFX/25_orc_walk_stone_1.wav";
-        static constexpr char s_damageSoundPath[] = "../assets/audio/Minifantasy_Dungeon_SFX/21_orc_damage_3.wav";
+        void loadSpriteSheets();
 
         void loadResources() {
             if (m_loaded) return;
 
-            r_attackSound = &SoundManager::get().loadSound(s_attackSoundPath);
-            r_stepSound = &SoundManager::get().loadSound(s_walkSoundPath);
-            r_damageSound = &SoundManager::get().loadSound(s_damageSoundPath);
+            r_idleSpriteSheet = &TextureAtlas::get().load(s_idleSpriteSheetPath);
+            r_attackSpriteSheet = &TextureAtlas::get().load(s_attackSpriteSheetPath);
+            r_walkSpriteSheet = &TextureAtlas::get().load(s_walkSpriteSheetPath);
+            r_damageSpriteSheet = &TextureAtlas::get().load(s_damageSpriteSheetPath);
 
-            loadTexture(m_idleSpriteSheetTexture, s_idleSpriteSheetPath);
-            loadTexture(m_attackSpriteSheetTexture, s_attackSpriteSheetPath);
-            loadTexture(m_walkSpriteSheetTexture, s_walkSpriteSheetPath);
-            loadTexture(m_damageSpriteSheetTexture, s_damageSpriteSheetPath);
+            loadSpriteSheets();
 
             m_loaded = true;
         }
 
-        void loadTexture(sf::Texture& texture, const std::string& filename) {
-            if (!texture.loadFromFile(filename))
-                throw std::runtime_error("Failed to load texture from file: " + filename);
-        }
-
     public:
         static Resources& get() {
             s_singleton.loadResources();
             return s_singleton;
         }
 
-        sf::Texture& idleSpriteSheetTexture() { return m_idleSpriteSheetTexture; }
-        sf::Texture& walkSpriteSheetTexture() { return m_walkSpriteSheetTexture; }
-        sf::Texture& damageSpriteSheetTexture() { return m_damageSpriteSheetTexture; }
-        sf::Texture& attackSpriteSheetTexture() { return m_attackSpriteSheetTexture; }
-        sf::SoundBuffer& attackSound() { return *r_attackSound; }
-        sf::SoundBuffer& stepSound() { return *r_stepSound; }
-        sf::SoundBuffer& damageSound() { return *r_damageSound; }
+        const TextureAtlas::Region& idleSpriteSheet() { return *r_idleSpriteSheet; }
+        const TextureAtlas::Region& walkSpriteSheet() { return *r_walkSpriteSheet; }
+        const TextureAtlas::Region& damageSpriteSheet() { return *r_damageSpriteSheet; }
+        const TextureAtlas::Region& attackSpriteSheet() { return *r_attackSpriteSheet; }
+        SpriteSheet& spriteSheet(OrcAnimation animation) { return m_spriteSheets[animation]; }
     };
 
-    float m_movementSpeed = 200.f;
+    enum State : std::uint8_t {
+        e_Moving        = 1 << 0,
+        e_Attacking     = 1 << 1,
+        e_TakingDamage  = 1 << 2,
+        e_FacingRight   = 1 << 3,
+        e_FacingForward = 1 << 4,
+        e_FootDown      = 1 << 5,
+        e_ReachedTarget = 1 << 6,
+    };
+
+    static constexpr float s_movementSpeed = 200.f;
+    // orcs this close to their target stop and attack it
+    static constexpr float s_attackRange = 100.f;
+    static constexpr float s_arrivedDamping = 0.9f;
     static constexpr float s_movementThreshold = 0.25f;
+    static inline const sf::Vector2f s_halfExtent { 15.f, 15.f };
 
-    SpriteSheet m_idleSpriteSheet;
-    SpriteSheet m_walkSpriteSheet;
-    SpriteSheet m_damageSpriteSheet;
-    SpriteSheet m_attackSpriteSheet;
+    static constexpr float s_maxHealth = 10.f;
+    static constexpr float s_attackCooldown = 1.f;
 
-    float m_health = 10.f;
+    // fewer orcs than this aren't worth handing to another thread
+    static constexpr std::size_t s_minimumJobSize = 256;
 
-    bool m_moving = false;
-    bool m_attacking = false;
-    bool m_takingDamage = false;
+    std::vector<float> m_health;
+    std::vector<float> m_attackCooldowns;
+    std::vector<std::uint8_t> m_states;
+    std::vector<float> m_animationIndices[e_OrcAnimationCount];
+    // sampled from the flow field for each orc as it steers
+    std::vector<sf::Vector2f> m_directions;
 
-    float m_attackCooldown = 0.f;
-    static constexpr float s_attackCooldown = 1.f;
+    SpatialHash m_broadphase { s_broadphaseCellSize };
+
+    OrcAnimation getCurrentAnimation(std::size_t orc) const;
+    // Sets up the sprite sheet every orc shares to draw this one, until the next call.
+    // Interpolation is as in draw.
+    SpriteSheet& poseSpriteSheet(std::size_t orc, float interpolation);
 
 public:
-    sf::Vector2f m_position {};
-    sf::Vector2f m_movement {};
+    // Orcs overlap when they're less than a width apart, the extra half width catches pairs that
+    // get pushed together while others are separated. An orc pushed further than that during one
+    // pass can still miss a pair testing every pair would separate, until the next frame.
+    static constexpr float s_broadphaseCellSize = 45.f;
+
+    std::vector<sf::Vector2f> m_positions;
+    // where each orc was at the start of the last simulation step, for drawing between steps
+    std::vector<sf::Vector2f> m_previousPositions;
+    std::vector<sf::Vector2f> m_movements;
 
-    Orc();
+    std::size_t size() const { return m_positions.size(); }
+    bool empty() const { return m_positions.empty(); }
 
-    static void preventIntersection(std::vector<Orc>& orcs, float deltaTime);
+    std::size_t add(sf::Vector2f position);
+    void remove(std::size_t orc);
+    void clear();
 
-    sf::Vector2f getFacingDirection();
-    sf::FloatRect getBounds();
-    SpriteSheet& getCurrentSpriteSheet();
+    // Call before each simulation step
+    void storePreviousPositions() { m_previousPositions = m_positions; }
+
+    static sf::FloatRect getBounds(sf::Vector2f position) {
+        return { position - s_halfExtent, s_halfExtent * 2.f };
+    }
 
-    bool runTowards(sf::Vector2f target);
+    sf::FloatRect getBounds(std::size_t orc) const { return getBounds(m_positions[orc]); }
 
-    void movementUpdate(float deltaTime);
-    void tileSetCollisionUpdate(TileSet& tileSet);
+    // Pushes a pair of overlapping orcs apart along the axis they overlap least on
+    static void separate(sf::Vector2f& position1, sf::Vector2f& position2, float deltaTime);
+    static void preventIntersection(std::span<sf::Vector2f> positions, float deltaTime, SpatialHash& broadphase);
+    void preventIntersection(float deltaTime) { preventIntersection(m_positions, deltaTime, m_broadphase); }
+    // Resolves every orc against the tile set in one batch
+    void tileSetCollisionUpdate(const TileSet& tileSet);
+    void tileSetCollisionUpdate(const PagedWorld& world);
+
+    // Orcs further than attack range head for the target, following the flow field around walls
+    // if there is one, the rest slow down and may attack it. Then every orc that isn't attacking
+    // moves. The flow field should already be updated for the target.
+    void steerTowards(sf::Vector2f target, float deltaTime, const FlowField* flowField = nullptr);
     void updateAnimation(float deltaTime);
+    // Orcs that reached their target attack it, if they can
+    void attackUpdate();
+    void takeSwordHits(const Player& player, float damage);
+    // Removes every orc with no health left, however it got there, which moves other orcs to new indices
+    void removeDead();
+
+    // Interpolation goes from 0 at the previous positions to 1 at the current ones
+    void draw(sf::RenderTarget& renderTarget, float interpolation = 1.f);
+    // Characters are sorted by the y position of their sprite's centre, which is its origin
+    void draw(DrawQueue& queue, float interpolation = 1.f);
+
+    // Every component array of a snapshot, read and checked but not yet restored
+    struct Snapshot {
+        std::vector<sf::Vector2f> m_positions;
+        std::vector<sf::Vector2f> m_previousPositions;
+        std::vector<sf::Vector2f> m_movements;
+        std::vector<float> m_health;
+        std::vector<float> m_attackCooldowns;
+        std::vector<std::uint8_t> m_states;
+        std::vector<float> m_animationIndices[e_OrcAnimationCount];
+    };
+
+    // Every component array as it is, between updates
+    void writeSnapshot(SnapshotWriter& writer) const;
+    // Throws if the arrays aren't all the same length
+    static Snapshot readSnapshot(SnapshotReader& reader);
+    void restoreSnapshot(Snapshot snapshot);
 
-    void draw(sf::RenderTarget& renderTarget);
+    void takeDamage(std::size_t orc, float damage);
+    void attack(std::size_t orc);
 
-    void takeDamage(float damage);
-    void attack();
-    
-    bool isAlive() const { return m_health > 0.f; }
-    bool canTakeDamage() const { return !m_takingDamage; }
-    bool isAttacking() const { return m_attacking; }
+    std::span<const float> getHealth() const { return m_health; }
+    bool isAlive(std::size_t orc) const { return m_health[orc] > 0.f; }
+    bool canTakeDamage(std::size_t orc) const { return !(m_states[orc] & e_TakingDamage); }
+    bool isAttacking(std::size_t orc) const { return m_states[orc] & e_Attacking; }
+    bool hasReachedTarget(std::size_t orc) const { return m_states[orc] & e_ReachedTarget; }
 
-    bool canAttack() const {
-        return !(isAttacking() || m_attackCooldown > 0.f);
+    bool canAttack(std::size_t orc) const {
+        return !(isAttacking(orc) || m_attackCooldowns[orc] > 0.f);
     }
-};
\ No newline at end of file
+};
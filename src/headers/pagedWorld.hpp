@@ -0,0 +1,173 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <textureAtlas.hpp>
+#include <tileLayout.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A tile map that is too big to keep in memory. The map is stored on disk as square regions of cells,
+// and a background thread loads the regions around a focus point, nearest first, and hands them to
+// the main thread, which drops the furthest ones when more than the memory budget is loaded.
+//
+// Cell and collision queries only see the active regions, the focus region and the ones touching it.
+// update waits for those to load, so what the queries see depends only on where the focus has been and
+// never on how fast the disk is. The regions around them are loaded ahead, so it rarely has to wait.
+// Cells anywhere else read as empty and never solid.
+class PagedWorld {
+public:
+    static constexpr int s_defaultRegionSize = 64;
+
+    // Converts a tile set layout file into a region file a band of rows at a time, so the layout
+    // never has to fit in memory
+    static void convertLayout(const std::string& layoutFilename,
+                              const std::string& worldFilename,
+                              int regionSize = s_defaultRegionSize);
+
+    // Whether the file starts like a world file
+    static bool isWorldFile(const std::string& filename);
+
+private:
+    // regions at most this many regions from the focus region, across or diagonally
+    static constexpr int s_activeRadius = 1;
+    static constexpr int s_loadRadius = 2;
+
+    struct Region {
+        std::vector<TileId> m_cells;
+        std::vector<std::uint8_t> m_solid;
+        sf::VertexArray m_vertices { sf::PrimitiveType::Triangles };
+    };
+
+    struct LoadedRegion {
+        std::int64_t m_index;
+        Region m_region;
+    };
+
+    // The tile set's part of an atlas page
+    TextureAtlas::Region m_atlasRegion;
+    int m_tileSetColumns = 0;
+    int m_tileSetRows = 0;
+    sf::Vector2f m_tileSize;
+    sf::Vector2f m_cellSize;
+    // there's nothing to draw them with when the atlas is headless
+    bool m_buildVertices = true;
+
+    std::set<int> m_wallTypes;
+
+    int m_regionSize = s_defaultRegionSize;
+    int m_gridColumns = 0;
+    int m_gridRows = 0;
+    int m_regionColumns = 0;
+    int m_regionRows = 0;
+    std::streamoff m_regionDataStart = 0;
+
+    std::size_t m_maxLoadedRegions = 0;
+
+    // Only touched by the main thread
+    std::unordered_map<std::int64_t, Region> m_regions;
+    sf::Vector2i m_focusRegion;
+    // the focus region update last waited for, queries see the regions around it
+    sf::Vector2i m_activeRegion { -s_activeRadius - 1, -s_activeRadius - 1 };
+    // set when the focus moves, or a load fails and has to be asked for again
+    bool m_requestsStale = true;
+
+    // Shared with the loading thread
+    std::mutex m_mutex;
+    std::condition_variable m_requestsChanged;
+    std::condition_variable m_regionLoaded;
+    std::deque<std::int64_t> m_requests;
+    std::vector<LoadedRegion> m_loaded;
+    std::exception_ptr m_error;
+    bool m_stopping = false;
+
+    // Only touched by the loading thread once it's started
+    std::ifstream m_file;
+    std::thread m_loadingThread;
+
+    void loadingThreadMain();
+    Region loadRegion(std::int64_t index);
+    void buildVertices(Region& region, sf::Vector2i regionCell) const;
+
+    void requestRegions();
+    // Moves the regions the loading thread has finished into m_regions, rethrowing a failed load
+    void takeLoadedRegions();
+    bool areActiveRegionsLoaded() const;
+    void evictRegions();
+
+    std::size_t getRegionBytes() const;
+
+    sf::Vector2i getRegionCoordinates(std::int64_t index) const {
+        return { static_cast<int>(index % m_regionColumns), static_cast<int>(index / m_regionColumns) };
+    }
+
+    std::int64_t getRegionIndex(sf::Vector2i region) const {
+        return region.x + static_cast<std::int64_t>(region.y) * m_regionColumns;
+    }
+
+    // The region a cell is in and the cell's index within it, or nullptr if the region isn't active
+    const Region* findRegion(const sf::Vector2i& cell, int& cellIndex) const;
+
+public:
+    // memoryBudget is in bytes, at least the regions in the load radius are always allowed
+    PagedWorld(const std::string& textureFilename,
+               int tileSetColumns,
+               int tileSetRows,
+               float scale,
+               const std::string& worldFilename,
+               std::size_t memoryBudget);
+
+    ~PagedWorld();
+
+    PagedWorld(const PagedWorld& other) = delete;
+    PagedWorld(PagedWorld&& other) = delete;
+    PagedWorld& operator=(const PagedWorld& other) = delete;
+    PagedWorld& operator=(PagedWorld&& other) = delete;
+
+    // Moves the focus to the region position is in, nothing is asked for until the next update
+    void setFocus(sf::Vector2f position);
+
+    // Asks for the regions around the focus if it moved, takes the regions that have finished loading,
+    // waits for any active ones that haven't, and evicts the furthest if over budget. Call before
+    // anything queries the world each step.
+    void update();
+
+    int gridColumns() const { return m_gridColumns; }
+    int gridRows() const { return m_gridRows; }
+    int regionSize() const { return m_regionSize; }
+
+    bool isActive(const sf::Vector2i& cell) const;
+
+    int getCellType(const sf::Vector2i& cell) const;
+    bool isSolid(const sf::Vector2i& cell) const;
+
+    void resolveCollisions(std::span<sf::Vector2f> centres, sf::Vector2f halfExtent) const;
+
+    // Truncates like TileSet, so collisions pick the same cells
+    sf::Vector2i getCellAtPosition(sf::Vector2f position) const {
+        return {
+            static_cast<int>(position.x / m_cellSize.x),
+            static_cast<int>(position.y / m_cellSize.y)
+        };
+    }
+
+    const sf::Vector2f& getCellSize() const { return m_cellSize; }
+    std::size_t getLoadedRegionCount() const { return m_regions.size(); }
+
+    sf::FloatRect getBounds() const {
+        return { { 0.f, 0.f }, { m_cellSize.x * m_gridColumns, m_cellSize.y * m_gridRows } };
+    }
+
+    // Draws every loaded region in view, active or not
+    void draw(sf::RenderTarget& target) const;
+};
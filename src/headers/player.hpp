@@ -1,19 +1,29 @@
 #pragma once
 #include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
 #include <spriteSheet.hpp>
-#include <soundManager.hpp>
+#include <soundQueue.hpp>
 #include <tileSet.hpp>
+#include <pagedWorld.hpp>
+#include <textureAtlas.hpp>
+#include <snapshot.hpp>
+#include <cstdint>
 #include <optional>
 
+// What the player is told to do for one simulation step, combined as flags
+enum PlayerInput : std::uint8_t {
+    e_NoInput   = 0,
+    e_MoveLeft  = 1,
+    e_MoveRight = 2,
+    e_MoveUp    = 4,
+    e_MoveDown  = 8,
+    e_Attack    = 16,
+};
+
 class Player {
     class Resources {
-        sf::SoundBuffer *r_attackSound,
-                        *r_stepSound;
-        
-        sf::Texture m_attackSpriteSheetTexture,
-                    m_idleSpriteSheetTexture,
-                    m_walkSpriteSheetTexture;
+        const TextureAtlas::Region *r_attackSpriteSheet,
+                                   *r_idleSpriteSheet,
+                                   *r_walkSpriteSheet;
         
         bool m_loaded = false;
         
@@ -23,9 +33,6 @@ class Player {
         static constexpr char s_idleSpriteSheetPath[] = "../assets/sprites/Minifantasy_Dungeon_v2.2_Free_Version/Minifantasy_Dungeon_Assets/Characters/Human/Idle.png";
         static constexpr char s_walkSpriteSheetPath[] = "../assets/sprites/Minifantasy_Dungeon_v2.2_Free_Version/Minifantasy_Dungeon_Assets/Characters/Human/Walk.png";
 
-        static constexpr char s_attackSoundPath[] = "../assets/audio/Minifantasy_Dungeon_SFX/07_human_atk_sword_1.wav";
-        static constexpr char s_stepSoundPath[] = "../assets/audio/Minifantasy_Dungeon_SFX/16_human_walk_stone_1.wav";
-
         Resources() = default;
         
         Resources(const Resources& other) = delete;
@@ -36,20 +43,12 @@ class Player {
         void loadResources() {
             if (m_loaded) return;
 
-            r_attackSound = &SoundManager::get().loadSound(s_attackSoundPath);
-            r_stepSound = &SoundManager::get().loadSound(s_stepSoundPath);
-
-            loadTexture(m_attackSpriteSheetTexture, s_attackSpriteSheetPath);
-            loadTexture(m_idleSpriteSheetTexture, s_idleSpriteSheetPath);
-            loadTexture(m_walkSpriteSheetTexture, s_walkSpriteSheetPath);
+            r_attackSpriteSheet = &TextureAtlas::get().load(s_attackSpriteSheetPath);
+            r_idleSpriteSheet = &TextureAtlas::get().load(s_idleSpriteSheetPath);
+            r_walkSpriteSheet = &TextureAtlas::get().load(s_walkSpriteSheetPath);
 
             m_loaded = true;
         }
-
-        void loadTexture(sf::Texture& texture, const std::string& filename) {
-            if (!texture.loadFromFile(filename))
-                throw std::runtime_error("Failed to load texture from file: " + filename);
-        }
     
     public:
         static Resources& get() {
@@ -57,11 +56,9 @@ class Player {
             return s_singleton;
         }
 
-        sf::SoundBuffer& attackSound() { return *r_attackSound; };
-        sf::SoundBuffer& stepSound() { return *r_stepSound; }
-        sf::Texture& attackSpriteSheetTexture() { return m_attackSpriteSheetTexture; }
-        sf::Texture& idleSpriteSheetTexture() { return m_idleSpriteSheetTexture; }
-        sf::Texture& walkSpriteSheetTexture() { return m_walkSpriteSheetTexture; }
+        const TextureAtlas::Region& attackSpriteSheet() { return *r_attackSpriteSheet; }
+        const TextureAtlas::Region& idleSpriteSheet() { return *r_idleSpriteSheet; }
+        const TextureAtlas::Region& walkSpriteSheet() { return *r_walkSpriteSheet; }
     };
 
     SpriteSheet m_attackSpriteSheet,
@@ -71,6 +68,9 @@ class Player {
     bool m_moving = false;
     bool m_footDown = false;
     bool m_attacking = false;
+    bool m_hadFootDown = false;
+    bool m_facingRight = true;
+    bool m_facingForward = true;
     sf::Vector2f m_movement;
 
     float m_movementSpeed = 200.f;
@@ -79,6 +79,8 @@ class Player {
 
 public:
     sf::Vector2f m_position;
+    // where the player was at the start of the last simulation step, for drawing between steps
+    sf::Vector2f m_previousPosition;
 
     Player();
 
@@ -88,14 +90,50 @@ public:
 
     const sf::Vector2f& getMovement() const { return m_movement; }
 
-    void draw(sf::RenderTarget& target);
+    // Call before each simulation step
+    void storePreviousPosition() { m_previousPosition = m_position; }
+    // Interpolation goes from 0 at the previous position to 1 at the current one
+    sf::Vector2f getInterpolatedPosition(float interpolation) const {
+        return m_previousPosition + (m_position - m_previousPosition) * interpolation;
+    }
+
+    void draw(sf::RenderTarget& target, float interpolation = 1.f);
+    // Characters are sorted by the y position of their sprite's centre, which is its origin
+    void draw(DrawQueue& queue, float interpolation = 1.f);
+
+    // The movement keys held right now, attacks come from key press events
+    static std::uint8_t readKeyboard();
 
-    void movementUpdate(float deltaTime);
-    void tileSetCollisionUpdate(TileSet& tileSet);
+    // Takes PlayerInput flags, attacking is left to attack()
+    void movementUpdate(float deltaTime, std::uint8_t input);
+    void tileSetCollisionUpdate(const TileSet& tileSet);
+    void tileSetCollisionUpdate(const PagedWorld& world);
     void animationUpdate(float deltaTime);
 
     void attack();
 
+    // A snapshot of the player, read but not yet restored
+    struct Snapshot {
+        sf::Vector2f m_position;
+        sf::Vector2f m_previousPosition;
+        sf::Vector2f m_movement;
+
+        bool m_moving;
+        bool m_footDown;
+        bool m_attacking;
+        bool m_hadFootDown;
+        bool m_facingRight;
+        bool m_facingForward;
+
+        float m_attackIndex;
+        float m_idleIndex;
+        float m_walkIndex;
+    };
+
+    void writeSnapshot(SnapshotWriter& writer) const;
+    static Snapshot readSnapshot(SnapshotReader& reader);
+    void restoreSnapshot(const Snapshot& snapshot);
+
     std::optional<sf::FloatRect> getSwordBounds() const;
     bool isSwordCollidingWith(const sf::FloatRect& bounds) const;
 };
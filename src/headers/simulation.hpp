@@ -0,0 +1,61 @@
+#pragma once
+
+#include <flowField.hpp>
+#include <level.hpp>
+#include <orc.hpp>
+#include <pagedWorld.hpp>
+#include <player.hpp>
+#include <tileSet.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Everything that changes as the game is played, stepped a fixed time at a time. Knows nothing
+// about windows or drawing, so it runs the same in the game and headless.
+class Simulation {
+    // before m_map, which takes the level's layout
+    std::uint64_t m_levelHash;
+
+    static std::uint64_t hashLevel(const Level& level);
+
+public:
+    static constexpr float s_tickLength = 1.f / 60.f;
+    // How much of a paged world is kept loaded
+    static constexpr std::size_t s_worldMemoryBudget = 64 << 20;
+
+    // Empty for paged levels
+    TileSet m_map;
+    Player m_player;
+    OrcStore m_orcs;
+    // shared by every orc, so it's only rebuilt when the player moves to another cell
+    FlowField m_flowField;
+    // Only for paged levels, collided against in place of m_map and streamed in around the player.
+    // A flow field would need the whole map, so orcs head straight for the player instead.
+    std::unique_ptr<PagedWorld> m_world;
+
+    // Builds the map from the level's layout and places its spawns
+    explicit Simulation(Level level);
+
+    // Steps everything by s_tickLength, input is PlayerInput flags
+    void tick(std::uint8_t input);
+
+    // FNV-1a of the level it was built from, everything but the file paths, so recordings and
+    // snapshots can tell they're being used on a different level
+    std::uint64_t getLevelHash() const { return m_levelHash; }
+
+    // FNV-1a of every position, movement and orc's health, bit for bit, so two runs only hash
+    // the same if they got exactly the same results
+    std::uint64_t getStateHash() const;
+
+    // Everything that changes as the game is played, between ticks, as a flat binary buffer.
+    // Restoring it carries on exactly where it was saved, on a simulation of the same level. A
+    // snapshot that can't be restored throws and leaves the simulation as it was.
+    std::vector<char> saveSnapshot() const;
+    void restoreSnapshot(std::span<const char> snapshot);
+
+    void saveSnapshotToFile(const std::string& filename) const;
+    void restoreSnapshotFromFile(const std::string& filename);
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// A flat buffer of plain values, read back in the order they were written. Arrays are copied
+// whole with their length in front, so saving and restoring component arrays is one memcpy each.
+class SnapshotWriter {
+    std::vector<char>& r_data;
+
+public:
+    explicit SnapshotWriter(std::vector<char>& data) : r_data(data) {}
+
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshots only hold plain values");
+
+        std::size_t offset = r_data.size();
+        r_data.resize(offset + sizeof(T));
+        std::memcpy(r_data.data() + offset, &value, sizeof(T));
+    }
+
+    template <typename T>
+    void writeArray(std::span<const T> values) {
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshots only hold plain values");
+
+        write(static_cast<std::uint64_t>(values.size()));
+
+        std::size_t offset = r_data.size();
+        r_data.resize(offset + values.size_bytes());
+        if (!values.empty()) std::memcpy(r_data.data() + offset, values.data(), values.size_bytes());
+    }
+};
+
+class SnapshotReader {
+    std::span<const char> m_data;
+    std::size_t m_offset = 0;
+
+    const char* take(std::size_t size) {
+        if (size > m_data.size() - m_offset)
+            throw std::runtime_error("Snapshot is truncated");
+
+        const char* data = m_data.data() + m_offset;
+        m_offset += size;
+        return data;
+    }
+
+public:
+    explicit SnapshotReader(std::span<const char> data) : m_data(data) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshots only hold plain values");
+
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void readArray(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshots only hold plain values");
+
+        std::uint64_t size = read<std::uint64_t>();
+        if (size > (m_data.size() - m_offset) / sizeof(T))
+            throw std::runtime_error("Snapshot is truncated");
+
+        values.resize(size);
+        if (size > 0) std::memcpy(values.data(), take(size * sizeof(T)), size * sizeof(T));
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SFML/Audio.hpp>
+#include <soundQueue.hpp>
 #include <string>
 #include <map>
 #include <vector>
@@ -11,6 +12,7 @@ class SoundManager {
     std::map<std::string, sf::SoundBuffer> m_soundBuffers;
     std::list<sf::Sound> m_playingSounds;
     std::list<sf::Music> m_playingMusic;
+    sf::SoundBuffer* r_soundEffects[e_SoundEffectCount] = {};
 
     SoundManager() = default;
 
@@ -33,5 +35,9 @@ public:
     sf::SoundBuffer& loadSound(const std::string& fileName);
     sf::Music& playMusic(const std::string& fileName);
     void playSound(sf::SoundBuffer& soundBuffer);
+    // Loads every SoundEffect, otherwise each is loaded the first time it plays
+    void loadSoundEffects();
+    // Plays everything pushed onto the SoundQueue since the last call
+    void playQueuedSounds();
     void cleanUpFinishedSounds();
 };
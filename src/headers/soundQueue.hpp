@@ -0,0 +1,46 @@
+#pragma once
+
+#include <jobSystem.hpp>
+
+enum SoundEffect : int {
+    e_PlayerAttackSound = 0,
+    e_PlayerStepSound,
+    e_OrcAttackSound,
+    e_OrcStepSound,
+    e_OrcDamageSound,
+    e_SoundEffectCount
+};
+
+// Sound effects the simulation asks for, played later by SoundManager. Kept apart from it so the
+// simulation needs neither an audio device nor sfml-audio.
+class SoundQueue {
+    CommandBuffers<SoundEffect> m_queuedSounds;
+    bool m_headless = false;
+
+    static SoundQueue s_singleton;
+
+    SoundQueue() = default;
+
+public:
+    SoundQueue(const SoundQueue& other) = delete;
+    SoundQueue(SoundQueue&& other) = delete;
+    SoundQueue& operator=(const SoundQueue& other) = delete;
+    SoundQueue& operator=(SoundQueue&& other) = delete;
+
+    static SoundQueue& get();
+
+    static const char* getPath(SoundEffect sound);
+
+    // Drops sounds instead of queueing them, for running with nothing to play them
+    void setHeadless(bool headless) { m_headless = headless; }
+    bool isHeadless() const { return m_headless; }
+
+    // Safe to call from inside JobSystem::parallelFor
+    void push(SoundEffect sound) {
+        if (!m_headless) m_queuedSounds.push(sound);
+    }
+
+    // Calls f with every sound queued since the last flush
+    template<typename F>
+    void flush(F&& f) { m_queuedSounds.flush(f); }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Buckets points by the grid cell they're in, so anything within one cell size of a point can be
+// found by looking at the nine cells around it. Cells are hashed into a table sized to the number
+// of points, so the world can be any size. Rebuilt from scratch with a counting sort.
+class SpatialHash {
+    float m_cellSize;
+
+    std::uint32_t m_tableMask = 0;
+    // where each bucket's entries start in m_entries, with one extra end offset
+    std::vector<std::uint32_t> m_bucketStarts;
+    std::vector<std::uint32_t> m_entries;
+    std::vector<sf::Vector2i> m_cells;
+    std::vector<std::uint32_t> m_nextEntries;
+    // kept between queries so getLaterNeighbours doesn't allocate
+    std::vector<std::uint32_t> m_neighbours;
+
+    sf::Vector2i getCell(sf::Vector2f position) const {
+        return {
+            static_cast<int>(std::floor(position.x / m_cellSize)),
+            static_cast<int>(std::floor(position.y / m_cellSize))
+        };
+    }
+
+    std::uint32_t getBucket(sf::Vector2i cell) const {
+        return (static_cast<std::uint32_t>(cell.x) * 73856093u ^ static_cast<std::uint32_t>(cell.y) * 19349663u) & m_tableMask;
+    }
+
+public:
+    explicit SpatialHash(float cellSize) : m_cellSize(cellSize) {}
+
+    void rebuild(std::span<const sf::Vector2f> positions);
+
+    // Calls f with the index of every point in the cells around the given point, as they were when
+    // last rebuilt. Points may be passed more than once if neighbouring cells share a bucket.
+    template<typename F>
+    void forEachNear(std::uint32_t point, F&& f) const {
+        sf::Vector2i cell = m_cells[point];
+
+        for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++) {
+            std::uint32_t bucket = getBucket({ cell.x + x, cell.y + y });
+
+            for (std::uint32_t i = m_bucketStarts[bucket]; i < m_bucketStarts[bucket + 1]; i++)
+                f(m_entries[i]);
+        }
+    }
+
+    // The points after the given one in the cells around it, each once and in index order. Only
+    // valid until the next call.
+    std::span<const std::uint32_t> getLaterNeighbours(std::uint32_t point);
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <limits>
+#include <vector>
+
+// Collects sprites as textured quads and draws them with one draw call per run of sprites
+// that share a texture. Sprites packed into the same atlas page all go in a single call.
+class SpriteBatch {
+    struct Run {
+        const sf::Texture* r_texture;
+        std::size_t m_firstVertex;
+    };
+
+    std::vector<sf::Vertex> m_vertices;
+    std::vector<Run> m_runs;
+
+    // Sprites entirely outside this aren't added
+    sf::FloatRect m_visibleArea {
+        { -std::numeric_limits<float>::max() / 2.f, -std::numeric_limits<float>::max() / 2.f },
+        { std::numeric_limits<float>::max(), std::numeric_limits<float>::max() }
+    };
+
+public:
+    // Empties the batch, keeping its memory for the next frame
+    void clear();
+    // As clear, and from now on skips sprites that aren't in the visible area
+    void clear(const sf::FloatRect& visibleArea);
+
+    void add(const sf::Sprite& sprite);
+    // A textureRect sized quad placed by transform, as an sf::Sprite would draw it
+    void add(const sf::Texture* texture, const sf::IntRect& textureRect, const sf::Transform& transform, sf::Color color = sf::Color::White);
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default) const;
+
+    std::size_t getSpriteCount() const { return m_vertices.size() / 6; }
+    std::size_t getDrawCallCount() const { return m_runs.size(); }
+};
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <textureAtlas.hpp>
+#include <spriteBatch.hpp>
+#include <drawQueue.hpp>
 
 #include <string>
 
 class SpriteSheet {
-    sf::Texture* r_texture;
+    const sf::Texture* r_texture;
+    // The part of the texture holding this sheet, usually its region of an atlas page
+    sf::IntRect m_textureRect;
 
     sf::IntRect getCurrentSpriteRect();
     sf::Vector2f getTileSize();
@@ -22,13 +27,26 @@ public:
     float m_animationSpeed = 15.f;
 
     SpriteSheet() = default;
-    SpriteSheet(sf::Texture& texture, int rows, int columns, sf::FloatRect region = { { 0, 0 }, { 1, 1 } });
+    // The animation region is a fraction of the sheet, not of the whole texture
+    SpriteSheet(const TextureAtlas::Region& atlasRegion, int rows, int columns, sf::FloatRect region = { { 0, 0 }, { 1, 1 } });
+    SpriteSheet(const sf::Texture& texture, int rows, int columns, sf::FloatRect region = { { 0, 0 }, { 1, 1 } });
 
-    sf::Texture& getTexture() { return *r_texture; }
+    // Only when it has one, sheets from a headless atlas don't
+    const sf::Texture& getTexture() const { return *r_texture; }
 
     bool hasFinished() const;
     int getIndex() const;
+    // Including how far through the current frame it is
+    float getExactIndex() const { return m_index; }
+
+    // For entities that keep their own index and share one sheet, these step and test an index
+    // the same way incrementIndex and hasFinished step and test the sheet's own
+    float getNextIndex(float index, float deltaTime) const;
+    bool hasFinished(float index) const;
+
     void setIndex(float index);
     void incrementIndex(float deltaTime);
     void draw(sf::RenderTarget& target);
+    void draw(SpriteBatch& batch);
+    void draw(DrawQueue& queue, std::uint32_t layer, float depth);
 };
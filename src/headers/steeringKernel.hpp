@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorised steering and movement for crowds of entities, eight at a time with AVX2 or four with
+// SSE2. Every implementation does the same float operations in the same order as the scalar one.
+class SteeringKernel {
+public:
+    enum class Implementation {
+        Scalar,
+        SSE2,
+        AVX2,
+        Best,
+    };
+
+    struct Parameters {
+        sf::Vector2f m_target;
+        // entities closer than this to the target have arrived
+        float m_arrivalDistance;
+        // arrived entities' movements are scaled by this every step
+        float m_arrivedDamping;
+        float m_speed;
+        float m_deltaTime;
+        // entities with any of these flags set don't move
+        std::uint8_t m_frozenFlags;
+        // set on entities that have arrived, cleared on the rest
+        std::uint8_t m_arrivedFlag;
+    };
+
+    static bool isSupported(Implementation implementation);
+    static const char* getName(Implementation implementation);
+
+    // Entities that haven't arrived get a unit movement straight towards the target, or along
+    // directions if it's given, then every entity that isn't frozen moves by its movement times
+    // speed and delta time.
+    static void steerTowards(
+        sf::Vector2f* positions,
+        sf::Vector2f* movements,
+        std::uint8_t* flags,
+        std::size_t count,
+        const Parameters& parameters,
+        const sf::Vector2f* directions = nullptr,
+        Implementation implementation = Implementation::Best);
+};
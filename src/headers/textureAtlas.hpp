@@ -0,0 +1,83 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <list>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Packs every sprite sheet and tile set into a few large pages, so drawing a scene only needs
+// a handful of texture binds. Images are packed onto shelves as they're first loaded, or the whole
+// atlas can be built ahead of time by atlasBuilder and loaded from its manifest.
+class TextureAtlas {
+public:
+    // Where an image ended up, draw r_texture using m_rect as the texture rect. Headless atlases
+    // have no textures, so r_texture is null.
+    struct Region {
+        const sf::Texture* r_texture = nullptr;
+        sf::IntRect m_rect;
+        std::size_t m_page = 0;
+    };
+
+private:
+    static constexpr unsigned int s_maxPageSize = 2048;
+    // Empty pixels between images, so filtering never samples a neighbour
+    static constexpr unsigned int s_padding = 1;
+
+    struct Shelf {
+        unsigned int m_top;
+        unsigned int m_height;
+        unsigned int m_nextLeft;
+    };
+
+    struct Page {
+        // only kept when headless, otherwise the pixels live in the texture alone
+        sf::Image m_image;
+        // never created when headless, as creating any texture opens a graphics context
+        std::optional<sf::Texture> m_texture;
+        std::vector<Shelf> m_shelves;
+        unsigned int m_nextShelfTop = 0;
+    };
+
+    // A list, so regions can keep pointers to the page textures as pages are added
+    std::list<Page> m_pages;
+    std::map<std::string, Region, std::less<>> m_regions;
+
+    unsigned int m_pageSize = 0;
+    bool m_headless = false;
+
+    static TextureAtlas s_singleton;
+
+    TextureAtlas() = default;
+
+    Page& addPage();
+    bool tryPack(Page& page, sf::Vector2u size, sf::Vector2u& position);
+    const Region& addImage(const std::string& name, const sf::Image& image);
+
+public:
+    TextureAtlas(const TextureAtlas& other) = delete;
+    TextureAtlas(TextureAtlas&& other) = delete;
+    TextureAtlas& operator=(const TextureAtlas& other) = delete;
+    TextureAtlas& operator=(TextureAtlas&& other) = delete;
+
+    static TextureAtlas& get();
+
+    // Packs images without creating any textures, for tools and for running without a graphics
+    // context. Must be set before anything is loaded.
+    void setHeadless(bool headless);
+    bool isHeadless() const { return m_headless; }
+
+    // The image's region, loading and packing it the first time it's asked for
+    const Region& load(const std::string& filename);
+
+    // Loads pages and regions written by saveToFiles, regions are named by the files they came from
+    void loadManifest(const std::string& manifestFilename);
+    // Writes each page to manifestFilename with its extension replaced by the page number and .png,
+    // then a csv manifest with a row per region: file, page, left, top, width, height
+    void saveToFiles(const std::string& manifestFilename) const;
+
+    std::size_t getPageCount() const { return m_pages.size(); }
+    std::size_t getRegionCount() const { return m_regions.size(); }
+};
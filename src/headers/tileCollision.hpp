@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <cmath>
+
+// Pushes an axis aligned box out of any solid cells next to, or under, the cell its centre is in.
+// isSolid(sf::Vector2i) says whether a cell is a wall and must handle cells off the edge of the grid.
+// Entities are independent of each other, so a batch can be split up and resolved in any order or in parallel.
+template <typename IsSolid>
+inline void resolveTileCollision(
+    sf::Vector2f& centre,
+    sf::Vector2f halfExtent,
+    sf::Vector2f cellSize,
+    const IsSolid& isSolid
+) {
+    // above, left, under, right, below
+    static constexpr int s_offsets[5][2] { { 0, -1 }, { -1, 0 }, { 0, 0 }, { 1, 0 }, { 0, 1 } };
+
+    // every neighbour is tested against where the box started, only the corrections accumulate
+    const sf::Vector2f start = centre;
+    const int cellX = static_cast<int>(start.x / cellSize.x);
+    const int cellY = static_cast<int>(start.y / cellSize.y);
+
+    for (const auto& offset : s_offsets) {
+        sf::Vector2i cell { cellX + offset[0], cellY + offset[1] };
+        if (!isSolid(cell)) continue;
+
+        float left = cellSize.x * cell.x;
+        float top = cellSize.y * cell.y;
+        float right = left + cellSize.x;
+        float bottom = top + cellSize.y;
+
+        bool intersects = start.x - halfExtent.x < right && left < start.x + halfExtent.x
+                       && start.y - halfExtent.y < bottom && top < start.y + halfExtent.y;
+        if (!intersects) continue;
+
+        sf::Vector2f tileCentre { left + cellSize.x * 0.5f, top + cellSize.y * 0.5f };
+        sf::Vector2f deltaPosition = centre - tileCentre;
+
+        if (std::abs(deltaPosition.x) > std::abs(deltaPosition.y))
+            centre.x = centre.x < tileCentre.x ? left - halfExtent.x : right + halfExtent.x;
+        else
+            centre.y = centre.y < tileCentre.y ? top - halfExtent.y : bottom + halfExtent.y;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tile indices are stored as 16 bits, which is plenty for any tile set we have
+using TileId = std::uint16_t;
+
+// The contents of a tile set layout file: the tile index of every grid cell and which tile indices are walls.
+struct TileLayout {
+    // Tile 0 is transparent in our tile sets, so cells using it aren't drawn
+    static constexpr TileId s_emptyTile = 0;
+
+    std::vector<int> m_wallTypes;
+    std::vector<TileId> m_cells;
+
+    int m_gridColumns = 0;
+    int m_gridRows = 0;
+
+    // The first row holds the wall types, the rest is the grid, one row per line.
+    // Large grids are split at line boundaries into up to threadCount chunks, parsed on the
+    // job system and each writing its own rows of m_cells. A threadCount of 0 uses every core.
+    static TileLayout loadFromFile(const std::string& layoutFilename, unsigned int threadCount = 0);
+
+    // A grid cell is either a tile index or a run of count copies of a tile written as tile*count,
+    // which is how compact layouts are saved. Returns false if the cell is neither.
+    static bool parseRun(std::string_view cell, TileId& tile, std::size_t& count);
+};
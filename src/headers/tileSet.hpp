@@ -1,27 +1,91 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <textureAtlas.hpp>
+#include <tileLayout.hpp>
+#include <snapshot.hpp>
 #include <set>
+#include <algorithm>
+#include <cstdint>
+#include <span>
 
 class TileSet {
-    sf::Texture m_texture;
-    sf::VertexArray m_vertices;
+    // The grid is drawn in square chunks of cells, so that only the chunks in view are drawn
+    static constexpr int s_chunkSize = 32;
 
-    std::vector<int> m_cells;
+    // The tile set's part of an atlas page
+    TextureAtlas::Region m_atlasRegion;
+    std::vector<sf::VertexArray> m_chunks;
+    int m_chunkColumns = 0;
+    int m_chunkRows = 0;
+
+    std::vector<TileId> m_cells;
     std::set<int> m_wallTypes;
 
-    int m_tileSetRows;
-    int m_tileSetColumns;
-    int m_gridRows;
-    int m_gridColumns;
-    float m_scale;
+    int m_tileSetRows = 0;
+    int m_tileSetColumns = 0;
+    int m_gridRows = 0;
+    int m_gridColumns = 0;
+    float m_scale = 1.f;
+
+    // Cached from the texture size, the tile set dimensions and the scale
+    sf::Vector2f m_tileSize;
+    sf::Vector2f m_cellSize;
+
+    // One byte per cell saying whether it's a wall, with a border of empty cells all the way
+    // around, so that collision checks never need to bounds check a cell's neighbours
+    std::vector<std::uint8_t> m_solid;
+
+    // Changes whenever m_solid does. Taken from a count shared by every tile set, so a tile set
+    // that's replaced by another never looks unchanged to anything caching its walls.
+    std::uint32_t m_solidityVersion = 0;
+    static inline std::uint32_t s_lastSolidityVersion = 0;
+    // The solidity version when all of m_solid was last worked out again, such as for new wall types
+    std::uint32_t m_solidityRebuildVersion = 0;
+    // How many times setCellType has turned a cell into a wall or out of one
+    std::uint32_t m_solidCellChangeCount = 0;
+
+    void updateCellSize();
+    void rebuildSolidity();
 
-    void setVertex(int index, sf::Vector2f position, sf::Vector2f texCoord) {
-        m_vertices[index].position = position;
-        m_vertices[index].texCoords = texCoord;
+    int getSolidityIndex(const sf::Vector2i& cell) const {
+        // anything further out than the border is treated as the border
+        int x = std::clamp(cell.x, -1, m_gridColumns) + 1;
+        int y = std::clamp(cell.y, -1, m_gridRows) + 1;
+        return x + y * (m_gridColumns + 2);
     }
 
+    // Chunks with cells written since their vertices were last built
+    std::set<int> m_dirtyChunks;
+
+    // Empty cells have no vertices, so a chunk is rebuilt as a whole when any of its cells change
+    void rebuildChunkVertices(int chunkX, int chunkY);
+    void appendCellVertices(sf::VertexArray& vertices, const sf::Vector2i& cell) const;
+
+    // Only needed when the tile set or scale changes, cell changes are handled by updateVertices
+    void rebuildVertices();
+
 public:
+    // Lets map[cell] = type be tracked as a change to the cell, so only its vertices are updated
+    class CellReference {
+        TileSet& r_tileSet;
+        sf::Vector2i m_cell;
+
+    public:
+        CellReference(TileSet& tileSet, const sf::Vector2i& cell) : r_tileSet(tileSet), m_cell(cell) {}
+
+        operator int() const { return r_tileSet.getCellType(m_cell); }
+
+        CellReference& operator=(int type) {
+            r_tileSet.setCellType(m_cell, type);
+            return *this;
+        }
+
+        CellReference& operator=(const CellReference& other) {
+            return *this = static_cast<int>(other);
+        }
+    };
+
     TileSet() = default;
 
     TileSet(const std::string& textureFilename,
@@ -29,6 +93,12 @@ public:
             int tileSetRows,
             float scale,
             const std::string& layoutFilename);
+
+    TileSet(const std::string& textureFilename,
+            int tileSetColumns,
+            int tileSetRows,
+            float scale,
+            TileLayout layout);
     
     TileSet(const std::string& textureFilename,
             int tileSetColumns,
@@ -37,15 +107,18 @@ public:
             int gridColumns,
             int gridRows);
 
-    const int& tileSetRows() { return m_tileSetRows; }
-    const int& tileSetColumns() { return m_tileSetColumns; }
-    const int& gridRows() { return m_gridRows; }
-    const int& gridColumns() { return m_gridColumns; }
+    const int& tileSetRows() const { return m_tileSetRows; }
+    const int& tileSetColumns() const { return m_tileSetColumns; }
+    const int& gridRows() const { return m_gridRows; }
+    const int& gridColumns() const { return m_gridColumns; }
 
-    void saveToFile(const std::string& layoutFilename);
+    // A compact layout writes runs of the same tile in a row as tile*count
+    void saveToFile(const std::string& layoutFilename, bool compact = false);
     
+    // Rebuilds the vertices of the chunks that have changed since the last update
     void updateVertices();
-    bool isOnTileSet(const sf::Vector2i& cell) {
+
+    bool isOnTileSet(const sf::Vector2i& cell) const {
         return cell.x >= 0
             && cell.y >= 0
             && cell.x < m_gridColumns
@@ -53,27 +126,78 @@ public:
     }
 
     void addWallTypes(const std::vector<int>& indices) {
-        for (auto index : indices) addWallType(index);
+        m_wallTypes.insert(indices.begin(), indices.end());
+        rebuildSolidity();
     }
     
-    void addWallType(int index) { m_wallTypes.insert(index); }
-    void removeWallType(int index) { m_wallTypes.erase(index); }
+    void addWallType(int index) {
+        m_wallTypes.insert(index);
+        rebuildSolidity();
+    }
+
+    void removeWallType(int index) {
+        m_wallTypes.erase(index);
+        rebuildSolidity();
+    }
 
-    bool isWallType(int type) {
+    bool isWallType(int type) const {
         return m_wallTypes.find(type) != m_wallTypes.end();
     }
 
-    int& getCellType(const sf::Vector2i& cell);
-    int& operator[](const sf::Vector2i& cell) {
+    // Whether the cell is a wall, cells off the grid never are, nor is anything on a tile set
+    // with no grid loaded
+    bool isSolid(const sf::Vector2i& cell) const {
+        return !m_solid.empty() && m_solid[getSolidityIndex(cell)];
+    }
+
+    const sf::Vector2f& getCellSize() const { return m_cellSize; }
+    std::uint32_t getSolidityVersion() const { return m_solidityVersion; }
+    std::uint32_t getSolidityRebuildVersion() const { return m_solidityRebuildVersion; }
+    std::uint32_t getSolidCellChangeCount() const { return m_solidCellChangeCount; }
+
+    // Pushes every box out of the walls around it, centres[i] is moved using halfExtents[i]
+    void resolveCollisions(std::span<sf::Vector2f> centres, std::span<const sf::Vector2f> halfExtents) const;
+    // As above for boxes that are all the same size
+    void resolveCollisions(std::span<sf::Vector2f> centres, sf::Vector2f halfExtent) const;
+
+    int getCellType(const sf::Vector2i& cell) const;
+    void setCellType(const sf::Vector2i& cell, int type);
+
+    int operator[](const sf::Vector2i& cell) const {
         return getCellType(cell);
     }
+
+    CellReference operator[](const sf::Vector2i& cell) {
+        return { *this, cell };
+    }
     
     sf::FloatRect getBounds() const;
 
-    sf::FloatRect getCellBounds(const sf::Vector2i& cell);
-    sf::Vector2i getCellAtPosition(sf::Vector2f position);
+    sf::FloatRect getCellBounds(const sf::Vector2i& cell) const {
+        return { { m_cellSize.x * cell.x, m_cellSize.y * cell.y }, m_cellSize };
+    }
+
+    sf::Vector2i getCellAtPosition(sf::Vector2f position) const {
+        return {
+            static_cast<int>(position.x / m_cellSize.x),
+            static_cast<int>(position.y / m_cellSize.y)
+        };
+    }
 
     void highlightCell(sf::RenderTarget& target, const sf::Vector2i& cell, const sf::Color& color);
 
+    // A snapshot's cells and wall types, read and checked but not yet restored
+    struct Snapshot {
+        std::vector<TileId> m_cells;
+        std::vector<int> m_wallTypes;
+    };
+
+    // The cells and wall types, restored onto a tile set with the same sized grid. Only the
+    // chunks and walls that differ are rebuilt.
+    void writeSnapshot(SnapshotWriter& writer) const;
+    // Throws if the snapshot's grid isn't the same size, leaving the tile set as it was
+    Snapshot readSnapshot(SnapshotReader& reader) const;
+    void restoreSnapshot(const Snapshot& snapshot);
+
     void draw(sf::RenderTarget& target);
 };
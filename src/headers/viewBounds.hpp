@@ -0,0 +1,19 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+
+// The axis aligned bounds of everything a view can see, which is larger than its size if it's rotated
+inline sf::FloatRect getViewBounds(const sf::View& view) {
+    float angle = view.getRotation() * 3.14159265f / 180.f;
+    float cosAngle = std::abs(std::cos(angle));
+    float sinAngle = std::abs(std::sin(angle));
+
+    sf::Vector2f viewSize = view.getSize();
+    sf::Vector2f viewExtent {
+        viewSize.x * cosAngle + viewSize.y * sinAngle,
+        viewSize.x * sinAngle + viewSize.y * cosAngle
+    };
+
+    return { view.getCenter() - viewExtent * 0.5f, viewExtent };
+}
@@ -0,0 +1,168 @@
+#include <simulation.hpp>
+#include <csvParser.hpp>
+#include <inputRecording.hpp>
+#include <soundQueue.hpp>
+#include <textureAtlas.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Holds a random direction for a random number of ticks, attacking now and then, roughly how
+// someone plays
+std::function<std::uint8_t(int)> makeRandomInput(unsigned int seed) {
+    return [random = std::mt19937(seed), held = std::uint8_t(e_NoInput), ticksLeft = 0](int) mutable {
+        if (ticksLeft-- <= 0) {
+            held = random() & (e_MoveLeft | e_MoveRight | e_MoveUp | e_MoveDown);
+            ticksLeft = 10 + random() % 50;
+        }
+
+        return static_cast<std::uint8_t>(held | (random() % 30 == 0 ? e_Attack : e_NoInput));
+    };
+}
+
+// Each row is a number of ticks and the keys held for them, any of L, R, U, D and A for attack.
+// The script starts again from the top when it runs out.
+std::function<std::uint8_t(int)> loadScriptedInput(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.good())
+        throw std::runtime_error("Could not open input script: " + filename);
+
+    std::vector<std::uint8_t> inputs;
+
+    CSVParser::forEachRow(file, [&](unsigned int row, std::span<const std::string_view> cells) {
+        if (cells.empty() || cells[0].empty()) return;
+
+        std::errc error;
+        int ticks = CSVParser::parseCell<int>(cells[0], error);
+        if (error != std::errc {})
+            throw std::runtime_error("Tick count on input script row " + std::to_string(row) + " isn't a number: " + filename);
+
+        if (ticks < 0)
+            throw std::runtime_error("Negative tick count on input script row " + std::to_string(row) + ": " + filename);
+
+        std::uint8_t input = e_NoInput;
+
+        for (char key : cells.size() > 1 ? cells[1] : std::string_view {})
+        switch (key) {
+        case 'L': input |= e_MoveLeft; break;
+        case 'R': input |= e_MoveRight; break;
+        case 'U': input |= e_MoveUp; break;
+        case 'D': input |= e_MoveDown; break;
+        case 'A': input |= e_Attack; break;
+        default: throw std::runtime_error("Unknown key on input script row " + std::to_string(row) + ": " + filename);
+        }
+
+        inputs.insert(inputs.end(), ticks, input);
+    });
+
+    if (inputs.empty())
+        throw std::runtime_error("Input script has no ticks: " + filename);
+
+    return [inputs = std::move(inputs)](int tick) { return inputs[tick % inputs.size()]; };
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 3 || argc > 5) {
+        std::cout << "Incorrect argument list\n"
+                  << "\tPlease provide:\n"
+                  << "\t1 - Path to the level csv file\n"
+                  << "\t2 - Number of ticks to run, at most the length of a replayed recording\n"
+                  << "\t3 - Optional, a random seed, the path to an input script, or the path to a recording\n"
+                  << "\t    to replay and check against, defaults to seed 0\n"
+                  << "\t4 - Optional, a path to record the run's input to"
+                  << std::endl;
+        return 1;
+    }
+
+    // no window, so no graphics context or audio device
+    TextureAtlas::get().setHeadless(true);
+    SoundQueue::get().setHeadless(true);
+
+    std::string levelPath { argv[1] };
+    std::string inputSource { argc > 3 ? argv[3] : "0" };
+    std::string recordPath { argc > 4 ? argv[4] : "" };
+
+    std::errc error;
+    int tickCount = CSVParser::parseCell<int>(argv[2], error);
+    if (error != std::errc {} || tickCount < 0) {
+        std::cout << "Number of ticks should be a whole number from 0 to "
+                  << std::numeric_limits<int>::max() << ": " << argv[2] << std::endl;
+        return 1;
+    }
+
+    Simulation simulation { Level::load(levelPath) };
+    std::size_t startingOrcCount = simulation.m_orcs.size();
+
+    InputRecording replay;
+    std::function<std::uint8_t(int)> input;
+
+    if (inputSource.find_first_not_of("0123456789") == std::string::npos) {
+        unsigned int seed = CSVParser::parseCell<unsigned int>(inputSource, error);
+        if (error != std::errc {}) {
+            std::cout << "Random seed should be a whole number from 0 to "
+                      << std::numeric_limits<unsigned int>::max() << ": " << inputSource << std::endl;
+            return 1;
+        }
+
+        input = makeRandomInput(seed);
+    } else if (InputRecording::isRecording(inputSource)) {
+        replay = InputRecording::loadFromFile(inputSource, simulation.getLevelHash());
+        input = [&replay](int tick) { return replay.getInput(tick); };
+        tickCount = std::min<int>(tickCount, replay.getTickCount());
+    } else {
+        input = loadScriptedInput(inputSource);
+    }
+
+    bool hashing = replay.getTickCount() > 0 || !recordPath.empty();
+    int divergedTick = -1;
+    InputRecording recording { simulation.getLevelHash() };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int tick = 0; tick < tickCount; tick++) {
+        std::uint8_t tickInput = input(tick);
+        simulation.tick(tickInput);
+
+        if (!hashing) continue;
+
+        std::uint64_t stateHash = simulation.getStateHash();
+
+        if (replay.getTickCount() > 0 && divergedTick < 0 && stateHash != replay.getStateHash(tick))
+            divergedTick = tick;
+
+        if (!recordPath.empty()) recording.record(tickInput, stateHash);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Ran " << tickCount << " ticks in " << seconds << "s\n";
+
+    if (tickCount > 0)
+        std::cout << tickCount / seconds << " ticks per second, "
+                  << seconds / tickCount * 1e6 << "us per tick\n";
+
+    std::cout << simulation.m_orcs.size() << " of " << startingOrcCount << " orcs left"
+              << std::endl;
+
+    if (!recordPath.empty()) recording.saveToFile(recordPath);
+
+    if (divergedTick >= 0) {
+        std::cout << "Replay diverged from the recording at tick " << divergedTick << std::endl;
+        return 1;
+    }
+
+    if (replay.getTickCount() > 0)
+        std::cout << "Replay matched the recording for all " << tickCount << " ticks" << std::endl;
+
+    return 0;
+}
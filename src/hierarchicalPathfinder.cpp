@@ -0,0 +1,473 @@
+#include <hierarchicalPathfinder.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace {
+
+struct Neighbour {
+    sf::Vector2i m_offset;
+    std::uint32_t m_cost;
+};
+
+const Neighbour s_neighbours[8] = {
+    { {  1,  0 }, 10 }, { { -1,  0 }, 10 },
+    { {  0,  1 }, 10 }, { {  0, -1 }, 10 },
+    { {  1,  1 }, 14 }, { { -1,  1 }, 14 },
+    { {  1, -1 }, 14 }, { { -1, -1 }, 14 },
+};
+
+// Entrances this wide or wider get one at each end, narrower ones get one in the middle
+constexpr int s_wideEntrance = 6;
+
+using QueueEntry = std::pair<std::uint32_t, int>;
+using MinQueue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>>;
+
+}
+
+bool HierarchicalPathfinder::isOpen(const TileSet& tileSet, const sf::IntRect& bounds, const sf::Vector2i& cell) {
+    return bounds.contains(cell) && !tileSet.isSolid(cell);
+}
+
+bool HierarchicalPathfinder::canStep(const TileSet& tileSet, const sf::IntRect& bounds, const sf::Vector2i& cell, const sf::Vector2i& offset) {
+    sf::Vector2i next = cell + offset;
+    if (!isOpen(tileSet, bounds, next)) return false;
+    if (offset.x == 0 || offset.y == 0) return true;
+
+    // moving diagonally past the corner of a wall would snag on it
+    return isOpen(tileSet, bounds, { next.x, cell.y }) && isOpen(tileSet, bounds, { cell.x, next.y });
+}
+
+std::uint32_t HierarchicalPathfinder::estimateCost(const sf::Vector2i& from, const sf::Vector2i& to) {
+    std::uint32_t dx = std::abs(to.x - from.x);
+    std::uint32_t dy = std::abs(to.y - from.y);
+
+    return s_straightCost * std::max(dx, dy) + (s_diagonalCost - s_straightCost) * std::min(dx, dy);
+}
+
+void HierarchicalPathfinder::LocalSearch::run(const TileSet& tileSet, const sf::IntRect& bounds, const sf::Vector2i& start) {
+    m_bounds = bounds;
+    m_distances.assign(bounds.width * bounds.height, s_unreachable);
+    m_parents.assign(bounds.width * bounds.height, -1);
+
+    auto index = [&](const sf::Vector2i& cell) {
+        return (cell.x - bounds.left) + (cell.y - bounds.top) * bounds.width;
+    };
+
+    if (!isOpen(tileSet, bounds, start)) return;
+
+    MinQueue queue;
+    m_distances[index(start)] = 0;
+    queue.push({ 0, index(start) });
+
+    while (!queue.empty()) {
+        auto [distance, cellIndex] = queue.top();
+        queue.pop();
+
+        if (distance > m_distances[cellIndex]) continue;
+
+        sf::Vector2i cell { bounds.left + cellIndex % bounds.width, bounds.top + cellIndex / bounds.width };
+
+        for (auto& neighbour : s_neighbours) {
+            if (!canStep(tileSet, bounds, cell, neighbour.m_offset)) continue;
+
+            int neighbourIndex = index(cell + neighbour.m_offset);
+            std::uint32_t neighbourDistance = distance + neighbour.m_cost;
+
+            if (neighbourDistance < m_distances[neighbourIndex]) {
+                m_distances[neighbourIndex] = neighbourDistance;
+                m_parents[neighbourIndex] = cellIndex;
+                queue.push({ neighbourDistance, neighbourIndex });
+            }
+        }
+    }
+}
+
+std::uint32_t HierarchicalPathfinder::LocalSearch::getDistance(const sf::Vector2i& cell) const {
+    if (!m_bounds.contains(cell)) return s_unreachable;
+    return m_distances[(cell.x - m_bounds.left) + (cell.y - m_bounds.top) * m_bounds.width];
+}
+
+std::vector<sf::Vector2i> HierarchicalPathfinder::LocalSearch::getPathTo(const sf::Vector2i& cell) const {
+    std::vector<sf::Vector2i> path;
+    if (getDistance(cell) == s_unreachable) return path;
+
+    for (int i = (cell.x - m_bounds.left) + (cell.y - m_bounds.top) * m_bounds.width; m_parents[i] >= 0; i = m_parents[i])
+        path.push_back({ m_bounds.left + i % m_bounds.width, m_bounds.top + i / m_bounds.width });
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+sf::IntRect HierarchicalPathfinder::getClusterBounds(int cluster) const {
+    sf::Vector2i topLeft {
+        cluster % m_clusterColumns * s_clusterSize,
+        cluster / m_clusterColumns * s_clusterSize
+    };
+
+    return {
+        topLeft,
+        { std::min(s_clusterSize, m_gridColumns - topLeft.x), std::min(s_clusterSize, m_gridRows - topLeft.y) }
+    };
+}
+
+int HierarchicalPathfinder::acquireNode(const sf::Vector2i& cell) {
+    int cellIndex = cell.x + cell.y * m_gridColumns;
+
+    auto it = m_nodeAtCell.find(cellIndex);
+    if (it != m_nodeAtCell.end()) {
+        m_nodes[it->second].m_entranceCount++;
+        return it->second;
+    }
+
+    int node;
+    if (m_freeNodes.empty()) {
+        node = static_cast<int>(m_nodes.size());
+        m_nodes.emplace_back();
+    } else {
+        node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+
+    m_nodes[node] = { cell, getCluster(cell), 1, {} };
+    m_nodeAtCell[cellIndex] = node;
+    m_clusterNodes[m_nodes[node].m_cluster].push_back(node);
+
+    return node;
+}
+
+void HierarchicalPathfinder::releaseNode(int node) {
+    if (--m_nodes[node].m_entranceCount > 0) return;
+
+    // edges into the node are all removed with its border, or rebuilt with its cluster
+    std::vector<int>& clusterNodes = m_clusterNodes[m_nodes[node].m_cluster];
+    clusterNodes.erase(std::find(clusterNodes.begin(), clusterNodes.end(), node));
+
+    m_nodeAtCell.erase(m_nodes[node].m_cell.x + m_nodes[node].m_cell.y * m_gridColumns);
+    m_nodes[node] = {};
+    m_freeNodes.push_back(node);
+}
+
+void HierarchicalPathfinder::rebuildBorder(const TileSet& tileSet, int cluster, bool below) {
+    std::vector<std::pair<int, int>>& entrances = m_borderEntrances[cluster * 2 + below];
+
+    for (auto [first, second] : entrances) {
+        std::erase_if(m_nodes[first].m_edges, [&](const Edge& edge) { return !edge.m_intra && edge.m_target == second; });
+        std::erase_if(m_nodes[second].m_edges, [&](const Edge& edge) { return !edge.m_intra && edge.m_target == first; });
+        releaseNode(first);
+        releaseNode(second);
+    }
+
+    entrances.clear();
+
+    sf::Vector2i clusterCell { cluster % m_clusterColumns, cluster / m_clusterColumns };
+    if (below ? clusterCell.y + 1 >= m_clusterRows : clusterCell.x + 1 >= m_clusterColumns) return;
+
+    sf::IntRect bounds = getClusterBounds(cluster);
+    sf::IntRect grid { { 0, 0 }, { m_gridColumns, m_gridRows } };
+
+    // walk along the border, the first cell is on this cluster's side and across is the other side
+    sf::Vector2i first = below ? sf::Vector2i { bounds.left, bounds.top + bounds.height - 1 }
+                               : sf::Vector2i { bounds.left + bounds.width - 1, bounds.top };
+    sf::Vector2i along = below ? sf::Vector2i { 1, 0 } : sf::Vector2i { 0, 1 };
+    sf::Vector2i across = below ? sf::Vector2i { 0, 1 } : sf::Vector2i { 1, 0 };
+    int length = below ? bounds.width : bounds.height;
+
+    auto addEntrance = [&](int position) {
+        sf::Vector2i cell = first + along * position;
+
+        int node = acquireNode(cell);
+        int otherNode = acquireNode(cell + across);
+
+        m_nodes[node].m_edges.push_back({ otherNode, s_straightCost, false, { cell + across } });
+        m_nodes[otherNode].m_edges.push_back({ node, s_straightCost, false, { cell } });
+
+        entrances.push_back({ node, otherNode });
+    };
+
+    int runStart = -1;
+
+    for (int i = 0; i <= length; i++) {
+        sf::Vector2i cell = first + along * i;
+        bool open = i < length && isOpen(tileSet, grid, cell) && isOpen(tileSet, grid, cell + across);
+
+        if (open && runStart < 0) runStart = i;
+        if (open || runStart < 0) continue;
+
+        if (i - runStart >= s_wideEntrance) {
+            addEntrance(runStart);
+            addEntrance(i - 1);
+        } else {
+            addEntrance((runStart + i - 1) / 2);
+        }
+
+        runStart = -1;
+    }
+}
+
+void HierarchicalPathfinder::rebuildClusterEdges(const TileSet& tileSet, int cluster) {
+    sf::IntRect bounds = getClusterBounds(cluster);
+    const std::vector<int>& nodes = m_clusterNodes[cluster];
+
+    for (int node : nodes)
+        std::erase_if(m_nodes[node].m_edges, [](const Edge& edge) { return edge.m_intra; });
+
+    LocalSearch search;
+
+    for (int node : nodes) {
+        search.run(tileSet, bounds, m_nodes[node].m_cell);
+
+        for (int other : nodes) {
+            if (other == node) continue;
+
+            std::uint32_t distance = search.getDistance(m_nodes[other].m_cell);
+            if (distance != s_unreachable)
+                m_nodes[node].m_edges.push_back({ other, distance, true, {} });
+        }
+    }
+}
+
+void HierarchicalPathfinder::rebuild(const TileSet& tileSet) {
+    m_gridColumns = tileSet.gridColumns();
+    m_gridRows = tileSet.gridRows();
+    m_clusterColumns = (m_gridColumns + s_clusterSize - 1) / s_clusterSize;
+    m_clusterRows = (m_gridRows + s_clusterSize - 1) / s_clusterSize;
+
+    int clusterCount = m_clusterColumns * m_clusterRows;
+
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_nodeAtCell.clear();
+    m_clusterNodes.assign(clusterCount, {});
+    m_borderEntrances.assign(clusterCount * 2, {});
+
+    m_solid.resize(static_cast<std::size_t>(m_gridColumns) * m_gridRows);
+
+    sf::Vector2i cell;
+    for (cell.y = 0; cell.y < m_gridRows; cell.y++)
+    for (cell.x = 0; cell.x < m_gridColumns; cell.x++)
+        m_solid[cell.x + cell.y * m_gridColumns] = tileSet.isSolid(cell);
+
+    for (int cluster = 0; cluster < clusterCount; cluster++) {
+        rebuildBorder(tileSet, cluster, false);
+        rebuildBorder(tileSet, cluster, true);
+    }
+
+    for (int cluster = 0; cluster < clusterCount; cluster++)
+        rebuildClusterEdges(tileSet, cluster);
+}
+
+bool HierarchicalPathfinder::update(const TileSet& tileSet) {
+    bool resized = tileSet.gridColumns() != m_gridColumns || tileSet.gridRows() != m_gridRows;
+    bool rebuildAll = !m_built || resized || tileSet.getSolidityRebuildVersion() != m_solidityRebuildVersion;
+
+    std::set<int> dirtyClusters;
+
+    if (!rebuildAll) {
+        std::uint32_t changedCells = 0;
+
+        for (auto& cell : m_dirtyCells) {
+            std::uint8_t& solid = m_solid[cell.x + cell.y * m_gridColumns];
+            if (solid == tileSet.isSolid(cell)) continue;
+
+            solid = tileSet.isSolid(cell);
+            changedCells++;
+            dirtyClusters.insert(getCluster(cell));
+        }
+
+        // a cell changed that wasn't invalidated, and there's no telling where
+        rebuildAll = changedCells != tileSet.getSolidCellChangeCount() - m_solidCellChangeCount;
+    }
+
+    m_dirtyCells.clear();
+    m_solidityRebuildVersion = tileSet.getSolidityRebuildVersion();
+    m_solidCellChangeCount = tileSet.getSolidCellChangeCount();
+    m_built = true;
+
+    if (rebuildAll) {
+        rebuild(tileSet);
+        return true;
+    }
+
+    if (!dirtyClusters.empty()) {
+        // a cell's wall can change the entrances on any border of its cluster, which changes
+        // the nodes of the clusters on the other side too
+        std::set<int> borders;
+        std::set<int> clusters;
+
+        for (int cluster : dirtyClusters) {
+            int x = cluster % m_clusterColumns;
+            int y = cluster / m_clusterColumns;
+
+            borders.insert(cluster * 2);
+            borders.insert(cluster * 2 + 1);
+            if (x > 0) borders.insert((cluster - 1) * 2);
+            if (y > 0) borders.insert((cluster - m_clusterColumns) * 2 + 1);
+
+            clusters.insert(cluster);
+            if (x > 0) clusters.insert(cluster - 1);
+            if (y > 0) clusters.insert(cluster - m_clusterColumns);
+            if (x + 1 < m_clusterColumns) clusters.insert(cluster + 1);
+            if (y + 1 < m_clusterRows) clusters.insert(cluster + m_clusterColumns);
+        }
+
+        for (int border : borders)
+            rebuildBorder(tileSet, border / 2, border % 2);
+
+        for (int cluster : clusters)
+            rebuildClusterEdges(tileSet, cluster);
+    }
+
+    return false;
+}
+
+void HierarchicalPathfinder::invalidateCell(const sf::Vector2i& cell) {
+    if (!m_built || cell.x < 0 || cell.y < 0 || cell.x >= m_gridColumns || cell.y >= m_gridRows) return;
+    m_dirtyCells.push_back(cell);
+}
+
+const std::vector<sf::Vector2i>& HierarchicalPathfinder::getEdgePath(const TileSet& tileSet, int source, Edge& edge) {
+    if (edge.m_path.empty()) {
+        LocalSearch search;
+        search.run(tileSet, getClusterBounds(m_nodes[source].m_cluster), m_nodes[source].m_cell);
+        edge.m_path = search.getPathTo(m_nodes[edge.m_target].m_cell);
+    }
+
+    return edge.m_path;
+}
+
+std::vector<sf::Vector2i> HierarchicalPathfinder::findPath(const TileSet& tileSet, const sf::Vector2i& start, const sf::Vector2i& goal) {
+    update(tileSet);
+
+    sf::IntRect grid { { 0, 0 }, { m_gridColumns, m_gridRows } };
+    if (!isOpen(tileSet, grid, start) || !isOpen(tileSet, grid, goal)) return {};
+
+    int startCluster = getCluster(start);
+    int goalCluster = getCluster(goal);
+
+    LocalSearch startSearch;
+    startSearch.run(tileSet, getClusterBounds(startCluster), start);
+
+    std::vector<sf::Vector2i> path { start };
+
+    if (startCluster == goalCluster && startSearch.getDistance(goal) != s_unreachable) {
+        std::vector<sf::Vector2i> local = startSearch.getPathTo(goal);
+        path.insert(path.end(), local.begin(), local.end());
+        return path;
+    }
+
+    LocalSearch goalSearch;
+    goalSearch.run(tileSet, getClusterBounds(goalCluster), goal);
+
+    // A* over the entrances, starting from every one the start can reach in its cluster and
+    // finishing at a virtual goal node reached from every one the goal can reach in its cluster
+    const int goalNode = static_cast<int>(m_nodes.size());
+
+    std::vector<std::uint32_t> costs(m_nodes.size() + 1, s_unreachable);
+    std::vector<int> parents(m_nodes.size() + 1, -1);
+    std::vector<int> parentEdges(m_nodes.size() + 1, -1);
+
+    MinQueue queue;
+
+    for (int node : m_clusterNodes[startCluster]) {
+        std::uint32_t distance = startSearch.getDistance(m_nodes[node].m_cell);
+        if (distance == s_unreachable) continue;
+
+        costs[node] = distance;
+        queue.push({ distance + estimateCost(m_nodes[node].m_cell, goal), node });
+    }
+
+    while (!queue.empty()) {
+        auto [estimate, node] = queue.top();
+        queue.pop();
+
+        if (node == goalNode) break;
+        if (estimate != costs[node] + estimateCost(m_nodes[node].m_cell, goal)) continue;
+
+        if (m_nodes[node].m_cluster == goalCluster) {
+            std::uint32_t distance = goalSearch.getDistance(m_nodes[node].m_cell);
+
+            if (distance != s_unreachable && costs[node] + distance < costs[goalNode]) {
+                costs[goalNode] = costs[node] + distance;
+                parents[goalNode] = node;
+                queue.push({ costs[goalNode], goalNode });
+            }
+        }
+
+        const std::vector<Edge>& edges = m_nodes[node].m_edges;
+        for (int i = 0; i < static_cast<int>(edges.size()); i++) {
+            std::uint32_t cost = costs[node] + edges[i].m_cost;
+            int target = edges[i].m_target;
+
+            if (cost < costs[target]) {
+                costs[target] = cost;
+                parents[target] = node;
+                parentEdges[target] = i;
+                queue.push({ cost + estimateCost(m_nodes[target].m_cell, goal), target });
+            }
+        }
+    }
+
+    if (costs[goalNode] == s_unreachable) return {};
+
+    std::vector<int> nodes;
+    for (int node = parents[goalNode]; node >= 0; node = parents[node])
+        nodes.push_back(node);
+
+    std::reverse(nodes.begin(), nodes.end());
+
+    std::vector<sf::Vector2i> toFirstNode = startSearch.getPathTo(m_nodes[nodes.front()].m_cell);
+    path.insert(path.end(), toFirstNode.begin(), toFirstNode.end());
+
+    for (std::size_t i = 1; i < nodes.size(); i++) {
+        Edge& edge = m_nodes[nodes[i - 1]].m_edges[parentEdges[nodes[i]]];
+        const std::vector<sf::Vector2i>& edgePath = getEdgePath(tileSet, nodes[i - 1], edge);
+        path.insert(path.end(), edgePath.begin(), edgePath.end());
+    }
+
+    // the goal search runs from the goal, so its path to the last node is walked backwards
+    std::vector<sf::Vector2i> fromLastNode = goalSearch.getPathTo(m_nodes[nodes.back()].m_cell);
+    std::reverse(fromLastNode.begin(), fromLastNode.end());
+    if (!fromLastNode.empty()) {
+        fromLastNode.erase(fromLastNode.begin());
+        path.insert(path.end(), fromLastNode.begin(), fromLastNode.end());
+        path.push_back(goal);
+    }
+
+    return path;
+}
+
+HierarchicalPathfinder::RequestId HierarchicalPathfinder::requestPath(const sf::Vector2i& start, const sf::Vector2i& goal) {
+    RequestId id = m_nextRequestId++;
+    m_requests.push_back({ id, start, goal });
+    return id;
+}
+
+void HierarchicalPathfinder::processRequests(const TileSet& tileSet, sf::Time budget) {
+    if (m_requests.empty()) return;
+
+    sf::Clock clock;
+
+    // a full rebuild can spend the budget on its own, the queries then wait for the next call
+    if (update(tileSet) && clock.getElapsedTime() >= budget) return;
+
+    do {
+        if (m_requests.empty()) return;
+
+        Request request = m_requests.front();
+        m_requests.pop_front();
+
+        m_results[request.m_id] = findPath(tileSet, request.m_start, request.m_goal);
+    } while (clock.getElapsedTime() < budget);
+}
+
+std::optional<std::vector<sf::Vector2i>> HierarchicalPathfinder::takePath(RequestId id) {
+    auto it = m_results.find(id);
+    if (it == m_results.end()) return std::nullopt;
+
+    std::vector<sf::Vector2i> path = std::move(it->second);
+    m_results.erase(it);
+    return path;
+}
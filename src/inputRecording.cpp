@@ -0,0 +1,112 @@
+#include <inputRecording.hpp>
+#include <mappedFile.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+// Recordings are the header, then the state hashes and the inputs as packed arrays. Everything is
+// in the byte order of the machine that recorded it, which the header records.
+constexpr char s_magic[4] = { 'S', 'F', 'I', 'R' };
+constexpr std::uint32_t s_version = 2;
+constexpr std::uint32_t s_byteOrderMark = 0x01020304;
+
+struct Header {
+    char m_magic[4];
+    std::uint32_t m_version;
+    std::uint32_t m_byteOrderMark;
+    std::uint32_t m_padding;
+    std::uint64_t m_levelHash;
+    std::uint64_t m_tickCount;
+};
+
+std::uint32_t swapBytes(std::uint32_t value) {
+    return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+}
+
+InputRecording InputRecording::loadFromFile(const std::string& filename, std::uint64_t levelHash) {
+    MappedFile file(filename);
+
+    const char* data = file.data();
+    std::size_t offset = 0;
+
+    auto read = [&](void* destination, std::size_t size) {
+        if (offset + size > file.size())
+            throw std::runtime_error("Input recording is truncated: " + filename);
+
+        if (size > 0) std::memcpy(destination, data + offset, size);
+        offset += size;
+    };
+
+    // only as far as the version first, older recordings' headers are shorter
+    Header header;
+    read(&header, offsetof(Header, m_byteOrderMark));
+
+    if (std::memcmp(header.m_magic, s_magic, sizeof(s_magic)) != 0)
+        throw std::runtime_error("Not an input recording: " + filename);
+
+    if (swapBytes(header.m_version) == s_version)
+        throw std::runtime_error("Input recording was made with the other byte order: " + filename);
+
+    if (header.m_version != s_version)
+        throw std::runtime_error(
+            "Input recording is version " + std::to_string(header.m_version) +
+            ", expected " + std::to_string(s_version) + ": " + filename);
+
+    read(&header.m_byteOrderMark, sizeof(header) - offsetof(Header, m_byteOrderMark));
+
+    if (header.m_byteOrderMark != s_byteOrderMark)
+        throw std::runtime_error("Input recording was made with the other byte order: " + filename);
+
+    if (header.m_levelHash != levelHash)
+        throw std::runtime_error("Input recording was made on a different level: " + filename);
+
+    if (header.m_tickCount > file.size())
+        throw std::runtime_error("Input recording is truncated: " + filename);
+
+    InputRecording recording { levelHash };
+
+    recording.m_stateHashes.resize(header.m_tickCount);
+    read(recording.m_stateHashes.data(), recording.m_stateHashes.size() * sizeof(std::uint64_t));
+
+    recording.m_inputs.resize(header.m_tickCount);
+    read(recording.m_inputs.data(), recording.m_inputs.size());
+
+    return recording;
+}
+
+void InputRecording::saveToFile(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.good())
+        throw std::runtime_error("Could not write input recording: " + filename);
+
+    Header header;
+    std::memcpy(header.m_magic, s_magic, sizeof(s_magic));
+    header.m_version = s_version;
+    header.m_byteOrderMark = s_byteOrderMark;
+    header.m_padding = 0;
+    header.m_levelHash = m_levelHash;
+    header.m_tickCount = m_inputs.size();
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_stateHashes.data()), m_stateHashes.size() * sizeof(std::uint64_t));
+    file.write(reinterpret_cast<const char*>(m_inputs.data()), m_inputs.size());
+    file.close();
+
+    if (!file.good())
+        throw std::runtime_error("Could not write input recording: " + filename);
+}
+
+bool InputRecording::isRecording(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+
+    char magic[sizeof(s_magic)] {};
+    file.read(magic, sizeof(magic));
+
+    return file.good() && std::memcmp(magic, s_magic, sizeof(s_magic)) == 0;
+}
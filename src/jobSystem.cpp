@@ -0,0 +1,122 @@
+#include <jobSystem.hpp>
+
+JobSystem JobSystem::s_singleton {};
+thread_local unsigned int JobSystem::s_workerIndex = 0;
+
+JobSystem& JobSystem::get() {
+    return s_singleton;
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers) worker.join();
+}
+
+void JobSystem::start() {
+    unsigned int threadCount = getThreadCount();
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        m_queues.push_back(std::make_unique<Queue>());
+
+    for (unsigned int i = 1; i < threadCount; i++)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+void JobSystem::workerLoop(unsigned int workerIndex) {
+    s_workerIndex = workerIndex;
+
+    while (true) {
+        if (tryRunJob(workerIndex)) continue;
+
+        std::unique_lock lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stopping || m_queuedJobs > 0; });
+
+        if (m_stopping) return;
+    }
+}
+
+bool JobSystem::tryRunJob(unsigned int workerIndex) {
+    Job job;
+    bool found = false;
+
+    // newest first from our own queue, while it's still in cache, then oldest first from the others
+    for (std::size_t i = 0; i < m_queues.size() && !found; i++) {
+        Queue& queue = *m_queues[(workerIndex + i) % m_queues.size()];
+        std::lock_guard lock(queue.m_mutex);
+
+        if (queue.m_jobs.empty()) continue;
+
+        if (i == 0) {
+            job = queue.m_jobs.back();
+            queue.m_jobs.pop_back();
+        } else {
+            job = queue.m_jobs.front();
+            queue.m_jobs.pop_front();
+        }
+
+        found = true;
+    }
+
+    if (!found) return false;
+
+    m_queuedJobs--;
+
+    try {
+        job.r_batch->r_function(job.r_batch->r_task, job.m_begin, job.m_end);
+    } catch (...) {
+        std::lock_guard lock(job.r_batch->m_errorMutex);
+        if (!job.r_batch->m_error) job.r_batch->m_error = std::current_exception();
+    }
+
+    job.r_batch->m_remaining.fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+void JobSystem::run(std::size_t count, std::size_t minimumRange, TaskFunction function, void* task) {
+    if (count == 0) return;
+
+    minimumRange = std::max<std::size_t>(minimumRange, 1);
+
+    if (getThreadCount() == 1 || count <= minimumRange) {
+        function(task, 0, count);
+        return;
+    }
+
+    std::call_once(m_started, &JobSystem::start, this);
+
+    // a few ranges per thread, so threads that finish early have something to steal
+    std::size_t rangeCount = std::min<std::size_t>((count + minimumRange - 1) / minimumRange, getThreadCount() * 4);
+
+    Batch batch;
+    batch.r_function = function;
+    batch.r_task = task;
+    batch.m_remaining = rangeCount;
+
+    unsigned int callerIndex = getWorkerIndex();
+
+    for (std::size_t i = 0; i < rangeCount; i++) {
+        Queue& queue = *m_queues[(callerIndex + i) % m_queues.size()];
+        std::lock_guard lock(queue.m_mutex);
+        queue.m_jobs.push_back({ &batch, count * i / rangeCount, count * (i + 1) / rangeCount });
+    }
+
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_queuedJobs += rangeCount;
+    }
+
+    m_wake.notify_all();
+
+    // help out rather than wait, which also lets a task start loops of its own
+    while (batch.m_remaining.load(std::memory_order_acquire) > 0)
+        if (!tryRunJob(callerIndex)) std::this_thread::yield();
+
+    if (batch.m_error) std::rethrow_exception(batch.m_error);
+}
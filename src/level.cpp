@@ -0,0 +1,295 @@
+#include <level.hpp>
+#include <csvParser.hpp>
+#include <mappedFile.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+std::map<std::string, ObjectType, std::less<>> s_objectNameToEnum {
+    { "PLAYER", e_Player },
+    { "ORC", e_Orc }
+};
+
+// Binary levels are the header, the two paths, padding to a multiple of four bytes, the wall types,
+// the 16 bit grid cells, padding again, and the spawns, as packed arrays. Everything is in the
+// byte order of the machine that compiled the level, which the header records.
+constexpr char s_binaryMagic[4] = { 'S', 'F', 'L', 'V' };
+constexpr std::uint32_t s_binaryVersion = 3;
+// Version 1 levels have 32 bit cells with no padding after them, and neither version 1 nor 2 has
+// a byte order mark, the rest of their layout is the same
+constexpr std::uint32_t s_oldestBinaryVersion = 1;
+constexpr std::uint32_t s_firstVersionWith16BitCells = 2;
+constexpr std::uint32_t s_firstVersionWithByteOrder = 3;
+constexpr std::uint32_t s_byteOrderMark = 0x01020304;
+
+struct BinaryHeader {
+    char m_magic[4];
+    std::uint32_t m_version;
+
+    std::int32_t m_tileSetColumns;
+    std::int32_t m_tileSetRows;
+    float m_mapScale;
+
+    std::int32_t m_gridColumns;
+    std::int32_t m_gridRows;
+
+    std::uint32_t m_wallTypeCount;
+    std::uint32_t m_spawnCount;
+    std::uint32_t m_tileSetPathLength;
+    std::uint32_t m_mapFilePathLength;
+
+    std::uint32_t m_byteOrderMark;
+};
+
+struct BinarySpawn {
+    std::int32_t m_type;
+    float m_x;
+    float m_y;
+};
+
+std::size_t alignToFour(std::size_t size) {
+    return (size + 3) & ~std::size_t { 3 };
+}
+
+std::uint32_t swapBytes(std::uint32_t value) {
+    return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+// Whether the file at path was written no earlier than the one at source, or there's no source
+bool isUpToDateWith(const std::filesystem::path& path, const std::filesystem::path& source) {
+    std::error_code error;
+    auto sourceTime = std::filesystem::last_write_time(source, error);
+    if (error) return true;
+
+    auto time = std::filesystem::last_write_time(path, error);
+    return !error && time >= sourceTime;
+}
+
+}
+
+ObjectType parseObject(std::string_view name) {
+    auto it = s_objectNameToEnum.find(name);
+    if (it == s_objectNameToEnum.end()) return e_None;
+    else return it->second;
+}
+
+Level Level::loadFromCSV(const std::string& filename) {
+    std::ifstream levelFile(filename);
+    if (!levelFile.good())
+        throw std::runtime_error("Could not open level file: " + filename);
+
+    Level level;
+
+    CSVParser::forEachRow(levelFile, [&](unsigned int row, std::span<const std::string_view> cells) {
+        if (row == 0) {
+            if (cells.size() < 5)
+                throw std::runtime_error("Level header should have five cells: " + filename);
+
+            level.m_tileSetPath    = std::string(cells[0]);
+            level.m_tileSetColumns = CSVParser::parseCell<int>(cells[1]);
+            level.m_tileSetRows    = CSVParser::parseCell<int>(cells[2]);
+            level.m_mapScale       = CSVParser::parseCell<float>(cells[3]);
+            level.m_mapFilePath    = std::string(cells[4]);
+
+            if (level.m_tileSetColumns <= 0 || level.m_tileSetRows <= 0)
+                throw std::runtime_error("Level tile set should have a positive number of columns and rows: " + filename);
+
+            return;
+        }
+
+        ObjectType type = cells.empty() ? e_None : parseObject(cells[0]);
+
+        if (type == e_None || cells.size() < 3) {
+            std::cerr << "Didn't recognise object: "
+                      << (cells.empty() ? std::string_view {} : cells[0])
+                      << std::endl;
+            return;
+        }
+
+        level.m_spawns.push_back({
+            type,
+            { CSVParser::parseCell<float>(cells[1]), CSVParser::parseCell<float>(cells[2]) }
+        });
+    });
+
+    if (!level.isPaged()) level.m_layout = TileLayout::loadFromFile(level.m_mapFilePath);
+
+    return level;
+}
+
+Level Level::loadFromBinary(const std::string& filename) {
+    MappedFile file(filename);
+
+    const char* data = file.data();
+    std::size_t offset = 0;
+
+    auto read = [&](void* destination, std::size_t size) {
+        if (offset + size > file.size())
+            throw std::runtime_error("Binary level is truncated: " + filename);
+
+        if (size > 0) std::memcpy(destination, data + offset, size);
+        offset += size;
+    };
+
+    BinaryHeader header;
+    read(&header, offsetof(BinaryHeader, m_byteOrderMark));
+
+    if (std::memcmp(header.m_magic, s_binaryMagic, sizeof(s_binaryMagic)) != 0)
+        throw std::runtime_error("Not a binary level: " + filename);
+
+    if (swapBytes(header.m_version) >= s_oldestBinaryVersion && swapBytes(header.m_version) <= s_binaryVersion)
+        throw std::runtime_error("Binary level was compiled with the other byte order, recompile it: " + filename);
+
+    if (header.m_version < s_oldestBinaryVersion || header.m_version > s_binaryVersion)
+        throw std::runtime_error(
+            "Binary level is version " + std::to_string(header.m_version) +
+            ", expected " + std::to_string(s_binaryVersion) + ", recompile it: " + filename);
+
+    if (header.m_version >= s_firstVersionWithByteOrder) {
+        read(&header.m_byteOrderMark, sizeof(header.m_byteOrderMark));
+
+        if (header.m_byteOrderMark != s_byteOrderMark)
+            throw std::runtime_error("Binary level was compiled with the other byte order, recompile it: " + filename);
+    }
+
+    if (header.m_gridColumns < 0 || header.m_gridRows < 0 || header.m_tileSetColumns <= 0 || header.m_tileSetRows <= 0)
+        throw std::runtime_error("Binary level has negative or empty dimensions: " + filename);
+
+    bool hasWideCells = header.m_version < s_firstVersionWith16BitCells;
+    std::size_t cellSize = hasWideCells ? sizeof(std::int32_t) : sizeof(TileId);
+
+    // checked before anything is allocated, so a corrupt header can't ask for a huge grid
+    std::size_t cellCount = static_cast<std::size_t>(header.m_gridColumns) * static_cast<std::size_t>(header.m_gridRows);
+    if (cellCount > file.size() / cellSize
+     || header.m_wallTypeCount > file.size()
+     || header.m_spawnCount > file.size()
+     || header.m_tileSetPathLength > file.size()
+     || header.m_mapFilePathLength > file.size())
+        throw std::runtime_error("Binary level is truncated: " + filename);
+
+    Level level;
+    level.m_tileSetColumns = header.m_tileSetColumns;
+    level.m_tileSetRows = header.m_tileSetRows;
+    level.m_mapScale = header.m_mapScale;
+
+    level.m_tileSetPath.resize(header.m_tileSetPathLength);
+    read(level.m_tileSetPath.data(), level.m_tileSetPath.size());
+
+    level.m_mapFilePath.resize(header.m_mapFilePathLength);
+    read(level.m_mapFilePath.data(), level.m_mapFilePath.size());
+
+    offset = alignToFour(offset);
+
+    TileLayout& layout = level.m_layout;
+    layout.m_gridColumns = header.m_gridColumns;
+    layout.m_gridRows = header.m_gridRows;
+
+    layout.m_wallTypes.resize(header.m_wallTypeCount);
+    read(layout.m_wallTypes.data(), layout.m_wallTypes.size() * sizeof(std::int32_t));
+
+    layout.m_cells.resize(cellCount);
+
+    if (hasWideCells) {
+        std::vector<std::int32_t> cells(cellCount);
+        read(cells.data(), cells.size() * sizeof(std::int32_t));
+
+        for (std::size_t i = 0; i < cellCount; i++) {
+            if (cells[i] < 0 || cells[i] > std::numeric_limits<TileId>::max())
+                throw std::runtime_error("Binary level has a tile index out of range " + std::to_string(cells[i]) + ": " + filename);
+
+            layout.m_cells[i] = static_cast<TileId>(cells[i]);
+        }
+    } else {
+        read(layout.m_cells.data(), layout.m_cells.size() * sizeof(TileId));
+    }
+
+    offset = alignToFour(offset);
+
+    std::vector<BinarySpawn> spawns(header.m_spawnCount);
+    read(spawns.data(), spawns.size() * sizeof(BinarySpawn));
+
+    level.m_spawns.reserve(spawns.size());
+    for (auto& spawn : spawns) {
+        if (spawn.m_type != e_Player && spawn.m_type != e_Orc)
+            throw std::runtime_error("Binary level has a spawn of unknown type " + std::to_string(spawn.m_type) + ": " + filename);
+
+        level.m_spawns.push_back({ static_cast<ObjectType>(spawn.m_type), { spawn.m_x, spawn.m_y } });
+    }
+
+    return level;
+}
+
+bool Level::isPaged() const {
+    return std::filesystem::path { m_mapFilePath }.extension() == ".world";
+}
+
+Level Level::load(const std::string& csvFilename) {
+    std::string binaryPath = getBinaryPath(csvFilename);
+
+    // a binary level older than the csv, or than the layout it was compiled from, has been edited
+    // since it was compiled
+    if (std::filesystem::exists(binaryPath) && isUpToDateWith(binaryPath, csvFilename)) {
+        Level level = loadFromBinary(binaryPath);
+        if (isUpToDateWith(binaryPath, level.m_mapFilePath)) return level;
+    }
+
+    return loadFromCSV(csvFilename);
+}
+
+std::string Level::getBinaryPath(const std::string& csvFilename) {
+    return std::filesystem::path(csvFilename).replace_extension(".lvl").string();
+}
+
+void Level::saveToBinary(const std::string& filename) const {
+    static_assert(sizeof(int) == sizeof(std::int32_t), "Wall types are written as 32 bit integers");
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.good())
+        throw std::runtime_error("Could not write binary level: " + filename);
+
+    BinaryHeader header;
+    std::memcpy(header.m_magic, s_binaryMagic, sizeof(s_binaryMagic));
+    header.m_version = s_binaryVersion;
+    header.m_tileSetColumns = m_tileSetColumns;
+    header.m_tileSetRows = m_tileSetRows;
+    header.m_mapScale = m_mapScale;
+    header.m_gridColumns = m_layout.m_gridColumns;
+    header.m_gridRows = m_layout.m_gridRows;
+    header.m_wallTypeCount = m_layout.m_wallTypes.size();
+    header.m_spawnCount = m_spawns.size();
+    header.m_tileSetPathLength = m_tileSetPath.size();
+    header.m_mapFilePathLength = m_mapFilePath.size();
+    header.m_byteOrderMark = s_byteOrderMark;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(m_tileSetPath.data(), m_tileSetPath.size());
+    file.write(m_mapFilePath.data(), m_mapFilePath.size());
+
+    std::size_t pathsEnd = sizeof(header) + m_tileSetPath.size() + m_mapFilePath.size();
+    const char padding[4] {};
+    file.write(padding, alignToFour(pathsEnd) - pathsEnd);
+
+    file.write(reinterpret_cast<const char*>(m_layout.m_wallTypes.data()), m_layout.m_wallTypes.size() * sizeof(std::int32_t));
+
+    std::size_t cellBytes = m_layout.m_cells.size() * sizeof(TileId);
+    file.write(reinterpret_cast<const char*>(m_layout.m_cells.data()), cellBytes);
+    file.write(padding, alignToFour(cellBytes) - cellBytes);
+
+    std::vector<BinarySpawn> spawns;
+    spawns.reserve(m_spawns.size());
+    for (auto& spawn : m_spawns)
+        spawns.push_back({ spawn.m_type, spawn.m_position.x, spawn.m_position.y });
+
+    file.write(reinterpret_cast<const char*>(spawns.data()), spawns.size() * sizeof(BinarySpawn));
+
+    if (!file.good())
+        throw std::runtime_error("Failed writing binary level: " + filename);
+}
@@ -0,0 +1,56 @@
+#include <level.hpp>
+#include <pagedWorld.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    bool paged = argc > 1 && std::string { argv[1] } == "--paged";
+    if (paged) {
+        argc--;
+        argv++;
+    }
+
+    if (argc != 2 && argc != 3) {
+        std::cout << "Incorrect argument list\n"
+                  << "\tPlease provide:\n"
+                  << "\t1 - Path to the level csv file\n"
+                  << "\t2 - (Optional) Path to write the binary level to,\n"
+                  << "\t    defaults to the level's path with a .lvl extension\n"
+                  << "\tOr to convert a map layout into a paged world:\n"
+                  << "\t--paged <layout csv file> [world file, defaults to a .world extension]"
+                  << std::endl;
+        return 1;
+    }
+
+    if (paged) {
+        std::string layoutFilePath { argv[1] };
+        std::string worldFilePath = argc == 3 ? argv[2]
+            : std::filesystem::path { layoutFilePath }.replace_extension(".world").string();
+
+        PagedWorld::convertLayout(layoutFilePath, worldFilePath);
+
+        std::cout << "Converted " << layoutFilePath << " to " << worldFilePath << ": "
+                  << PagedWorld::s_defaultRegionSize << "x" << PagedWorld::s_defaultRegionSize << " regions, "
+                  << std::filesystem::file_size(worldFilePath) << " bytes\n"
+                  << "Use it as a level's map file to stream it in as the game runs"
+                  << std::endl;
+
+        return 0;
+    }
+
+    std::string levelFilePath { argv[1] };
+    std::string binaryFilePath = argc == 3 ? argv[2] : Level::getBinaryPath(levelFilePath);
+
+    Level level = Level::loadFromCSV(levelFilePath);
+    level.saveToBinary(binaryFilePath);
+
+    std::cout << "Compiled " << levelFilePath << " to " << binaryFilePath << ": "
+              << level.m_layout.m_gridColumns << "x" << level.m_layout.m_gridRows << " grid, "
+              << level.m_layout.m_wallTypes.size() << " wall types, "
+              << level.m_spawns.size() << " spawns"
+              << std::endl;
+
+    return 0;
+}
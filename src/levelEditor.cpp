@@ -1,29 +1,13 @@
 #include <player.hpp>
 #include <orc.hpp>
+#include <soundManager.hpp>
 #include <tileSet.hpp>
 
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <csvParser.hpp>
-
-enum ObjectType : int {
-    e_None = 0,
-    e_Player,
-    e_Orc,
-};
-
-std::map<std::string, ObjectType> s_objectNameToEnum {
-    { "PLAYER", e_Player },
-    { "ORC", e_Orc }
-};
-
-ObjectType parseObject(const std::string& name) {
-    auto it = s_objectNameToEnum.find(name);
-    if (it == s_objectNameToEnum.end()) return e_None;
-    else return it->second;
-}
+#include <level.hpp>
 
 int main(int argc, char** argv) {
     if (argc != 2) {
@@ -44,38 +28,34 @@ int main(int argc, char** argv) {
 
     TileSet map;
     Player player;
-    std::vector<Orc> orcs;
+    OrcStore orcs;
 
     if (levelFile.good()) {
-        CSVParser csvParser { levelFile, false };
         levelFile.close();
 
-        tileSetPath    =           csvParser.getCell(0, 0);
-        tileSetColumns = std::atoi(csvParser.getCell(0, 1).c_str());
-        tileSetRows    = std::atoi(csvParser.getCell(0, 2).c_str());
-        mapScale       = std::atof(csvParser.getCell(0, 3).c_str());
-        mapFilePath    =           csvParser.getCell(0, 4);
+        Level level = Level::loadFromCSV(levelFilePath);
 
-        for (int i = 2; i < csvParser.getRowCount(); i++) {
-            switch (parseObject(csvParser.getCell(i, 0))) {
-            case e_Player: {
-                player.m_position.x = std::atof(csvParser.getCell(i, 1).c_str());
-                player.m_position.y = std::atof(csvParser.getCell(i, 2).c_str());
+        if (level.isPaged()) {
+            std::cout << "Paged levels can't be edited, edit the layout the world was converted from: "
+                      << level.m_mapFilePath << std::endl;
+            return 1;
+        }
 
-                break;
-            }
-            case e_Orc: {
-                orcs.emplace_back();
-                orcs.back().m_position.x = std::atof(csvParser.getCell(i, 1).c_str());
-                orcs.back().m_position.y = std::atof(csvParser.getCell(i, 2).c_str());
+        tileSetPath    = level.m_tileSetPath;
+        tileSetColumns = level.m_tileSetColumns;
+        tileSetRows    = level.m_tileSetRows;
+        mapScale       = level.m_mapScale;
+        mapFilePath    = level.m_mapFilePath;
 
+        for (auto& spawn : level.m_spawns) {
+            switch (spawn.m_type) {
+            case e_Player:
+                player.m_position = spawn.m_position;
                 break;
-            }
-            default:
-                std::cerr << "Didn't recognise object name: "
-                          << csvParser.getCell(i, 0)
-                          << std::endl;
+            case e_Orc:
+                orcs.add(spawn.m_position);
                 break;
+            default: break;
             }
         }
     } else {
@@ -97,13 +77,16 @@ int main(int argc, char** argv) {
     sf::RenderWindow window { { 1280u, 720u }, "Level Editor" };
     window.setFramerateLimit(144);
 
+    SoundManager::get().loadSoundEffects();
+
     sf::Clock clock;
     sf::Time lastFrameStart = clock.getElapsedTime();
 
     ObjectType brushType = e_None;
 
     Player previewPlayer;
-    Orc previewOrc;
+    OrcStore previewOrc;
+    previewOrc.add({});
 
     sf::View view { {}, sf::Vector2f { window.getSize() } };
 
@@ -112,7 +95,7 @@ int main(int argc, char** argv) {
         mousePosition += view.getCenter() - view.getSize() * 0.5f;
 
         previewPlayer.m_position = mousePosition;
-        previewOrc.m_position = mousePosition;
+        previewOrc.m_positions[0] = mousePosition;
 
         for (sf::Event event; window.pollEvent(event);)
         switch (event.type) {
@@ -134,16 +117,16 @@ int main(int argc, char** argv) {
                      << tileSetColumns << ','
                      << tileSetRows << ','
                      << mapScale << ','
-                     << mapFilePath << std::endl;
+                     << mapFilePath << '\n';
                 
                 file << "PLAYER" << ','
                      << player.m_position.x << ','
-                     << player.m_position.y << std::endl;
+                     << player.m_position.y << '\n';
 
-                for (auto& orc : orcs)
+                for (auto& position : orcs.m_positions)
                 file << "ORC" << ','
-                     << orc.m_position.x << ','
-                     << orc.m_position.y << std::endl;
+                     << position.x << ','
+                     << position.y << '\n';
 
                 file.close();
 
@@ -160,7 +143,7 @@ int main(int argc, char** argv) {
 
                 break;
             case e_Orc:
-                orcs.push_back(previewOrc);
+                orcs.add(mousePosition);
 
                 break;
             default: break;
@@ -186,18 +169,20 @@ int main(int argc, char** argv) {
         view.setCenter(viewCenter);
 
         player.animationUpdate(0.f);
-        for (auto& orc : orcs) orc.updateAnimation(0.f);
+        orcs.updateAnimation(0.f);
 
         previewPlayer.animationUpdate(0.f);
         previewOrc.updateAnimation(0.f);
 
+        SoundManager::get().playQueuedSounds();
+
         window.clear();
 
         window.setView(view);
 
         map.draw(window);
         player.draw(window);
-        for (auto& orc : orcs) orc.draw(window);
+        orcs.draw(window);
 
         switch (brushType) {
         case e_Player : previewPlayer.draw(window); break;
@@ -1,15 +1,21 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <random>
+#include <filesystem>
+#include <stdexcept>
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 
-#include <player.hpp>
-#include <tileSet.hpp>
-#include <orc.hpp>
-#include <csvParser.hpp>
+#include <simulation.hpp>
+#include <inputRecording.hpp>
+#include <soundManager.hpp>
+#include <textureAtlas.hpp>
+#include <spriteBatch.hpp>
+#include <drawQueue.hpp>
+#include <viewBounds.hpp>
 
 static const std::string BACKGROUND_MUSIC_PATH {
     "../assets/audio/Minifantasy_Dungeon_Music/Music/Goblins_Den_(Regular).wav"
@@ -23,74 +29,66 @@ static const std::string ORC_HIT_SOUND {
     "../assets/audio/Minifantasy_Dungeon_SFX/21_orc_damage_2.wav"
 };
 
+// The level played unless --level names another, which can be a paged one
 static const std::string LEVEL_PATH { "../assets/testLevel.csv" };
 
-enum ObjectType : int {
-    e_None = 0,
-    e_Player,
-    e_Orc,
-};
+// The simulation always steps by the same time, however often frames are drawn
+static const sf::Time TICK_LENGTH = sf::seconds(Simulation::s_tickLength);
 
-std::map<std::string, ObjectType> s_objectNameToEnum {
-    { "PLAYER", e_Player },
-    { "ORC", e_Orc }
-};
+// After a hitch the simulation drops the time it can't catch up on, rather than taking longer
+// and longer each frame trying to
+static constexpr int MAX_TICKS_PER_FRAME = 5;
 
-ObjectType parseObject(const std::string& name) {
-    auto it = s_objectNameToEnum.find(name);
-    if (it == s_objectNameToEnum.end()) return e_None;
-    else return it->second;
-}
+// F5 saves a snapshot of the game here and F9 goes back to it
+static const std::string QUICKSAVE_PATH { "quicksave.snap" };
+
+// Written by atlasBuilder, sprites missing from it are packed as they're loaded
+static const std::string ATLAS_PATH { "../assets/atlas.csv" };
+
+int main(int argc, const char** argv) {
+    // --record writes every tick's input to a file when the game closes, --replay plays one back
+    // in place of the keyboard and checks each tick matches how it went when it was recorded
+    std::string recordPath, replayPath;
+    std::string levelPath { LEVEL_PATH };
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument { argv[i] };
+
+        if (argument == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (argument == "--replay" && i + 1 < argc) replayPath = argv[++i];
+        else if (argument == "--level" && i + 1 < argc) levelPath = argv[++i];
+        else {
+            std::cout << "Unknown argument: " << argument << "\n"
+                      << "\tUsage: main [--record <file>] [--replay <file>] [--level <file>]"
+                      << std::endl;
+            return 1;
+        }
+    }
 
-int main() {
     sf::RenderWindow window { { 1280u, 720u }, "SFML Test" };
     window.setFramerateLimit(144);
 
+    if (std::filesystem::exists(ATLAS_PATH))
+        TextureAtlas::get().loadManifest(ATLAS_PATH);
+
+    SoundManager::get().loadSoundEffects();
+
     sf::Music& backgroundMusic = SoundManager::get().playMusic(BACKGROUND_MUSIC_PATH);
     sf::Music& battleMusic = SoundManager::get().playMusic(BATTLE_MUSIC_PATH);
     battleMusic.stop();
     
-    TileSet map;
-    Player player;
-    std::vector<Orc> orcs;
+    Simulation simulation { Level::load(levelPath) };
 
-    std::ifstream levelFile(LEVEL_PATH);
-    if (!levelFile.good())
-        throw std::runtime_error("Could not open level file: " + LEVEL_PATH);
-    
-    CSVParser csvParser { levelFile, false };
-    levelFile.close();
-
-    map = TileSet {
-                                     csvParser.getCell(0, 0),
-                           std::atoi(csvParser.getCell(0, 1).c_str()),
-                           std::atoi(csvParser.getCell(0, 2).c_str()),
-        static_cast<float>(std::atof(csvParser.getCell(0, 3).c_str())),
-                                     csvParser.getCell(0, 4)
-    };
-
-    for (int i = 1; i < csvParser.getRowCount(); i++) {
-        switch (parseObject(csvParser.getCell(i, 0))) {
-        case e_Player: {
-            player.m_position.x = std::atof(csvParser.getCell(i, 1).c_str());
-            player.m_position.y = std::atof(csvParser.getCell(i, 2).c_str());
-
-            break;
-        }
-        case e_Orc: {
-            orcs.emplace_back();
-            orcs.back().m_position.x = std::atof(csvParser.getCell(i, 1).c_str());
-            orcs.back().m_position.y = std::atof(csvParser.getCell(i, 2).c_str());
+    InputRecording recording { simulation.getLevelHash() };
+    InputRecording replay;
+    if (!replayPath.empty()) replay = InputRecording::loadFromFile(replayPath, simulation.getLevelHash());
 
-            break;
-        }
-        default:
-            std::cerr << "Didn't recognise object name: "
-                        << csvParser.getCell(i, 0)
-                        << std::endl;
-            break;
-        }
-    }
+    std::size_t tick = 0;
+    bool replayMatched = true;
+
+    TileSet& map = simulation.m_map;
+    Player& player = simulation.m_player;
+    OrcStore& orcs = simulation.m_orcs;
 
     sf::FloatRect mapBounds = map.getBounds();
 
@@ -98,9 +96,16 @@ int main() {
 
     sf::Clock clock;
     sf::Time lastFrameStart = clock.getElapsedTime();
+    sf::Time unsimulatedTime;
 
     int hitCount = 0;
 
+    // attacks pressed since the last tick, so none are missed on frames without one
+    std::uint8_t pendingInput = e_NoInput;
+
+    DrawQueue drawQueue;
+    SpriteBatch spriteBatch;
+
     while (window.isOpen()) {
         for (auto event = sf::Event{}; window.pollEvent(event);)
         switch (event.type) {
@@ -109,7 +114,23 @@ int main() {
         case sf::Event::KeyPressed:
             switch (event.key.scancode) {
             case sf::Keyboard::Scancode::Z:
-                player.attack();
+                pendingInput |= e_Attack;
+                break;
+            // a quicksave that can't be written or read is reported, and the game carries on
+            case sf::Keyboard::Scancode::F5:
+                try {
+                    simulation.saveSnapshotToFile(QUICKSAVE_PATH);
+                } catch (const std::runtime_error& error) {
+                    std::cout << "Quicksave failed: " << error.what() << std::endl;
+                }
+                break;
+            case sf::Keyboard::Scancode::F9:
+                try {
+                    if (std::filesystem::exists(QUICKSAVE_PATH))
+                        simulation.restoreSnapshotFromFile(QUICKSAVE_PATH);
+                } catch (const std::runtime_error& error) {
+                    std::cout << "Quickload failed: " << error.what() << std::endl;
+                }
                 break;
             default: break;
             }
@@ -117,52 +138,66 @@ int main() {
         }
 
         sf::Time currentFrameStart = clock.getElapsedTime();
-        float deltaTime = (currentFrameStart - lastFrameStart).asSeconds();
+        sf::Time frameTime = currentFrameStart - lastFrameStart;
 
-        player.movementUpdate(deltaTime);
-        player.tileSetCollisionUpdate(map);
-        player.animationUpdate(deltaTime);
+        unsimulatedTime += frameTime;
 
-        for (auto it = orcs.begin(); it != orcs.end();) {
-            auto& orc = *it;
+        int tickCount = 0;
+        for (; unsimulatedTime >= TICK_LENGTH && tickCount < MAX_TICKS_PER_FRAME; tickCount++) {
+            bool replaying = tick < replay.getTickCount();
 
-            bool orcHasReachedPlayer = orc.runTowards(player.m_position);
+            std::uint8_t input = replaying ? replay.getInput(tick) : Player::readKeyboard() | pendingInput;
+            pendingInput = e_NoInput;
 
-            if (!orc.isAttacking())
-                orc.movementUpdate(deltaTime);
-            
-            orc.tileSetCollisionUpdate(map);
-            orc.updateAnimation(deltaTime);
+            simulation.tick(input);
 
-            if (orcHasReachedPlayer && orc.canAttack())
-                orc.attack();
+            if (replaying || !recordPath.empty()) {
+                std::uint64_t stateHash = simulation.getStateHash();
 
-            if (orc.canTakeDamage() && player.isSwordCollidingWith(orc.getBounds()))
-                orc.takeDamage(5.f);
+                if (replaying && replayMatched && stateHash != replay.getStateHash(tick)) {
+                    std::cout << "Replay diverged from the recording at tick " << tick << std::endl;
+                    replayMatched = false;
+                }
+
+                if (!recordPath.empty()) recording.record(input, stateHash);
+            }
 
-            if (!orc.isAlive()) {
-                std::swap(*it, orcs.back());
-                orcs.pop_back();
-            } else it++;
+            if (++tick == replay.getTickCount() && replayMatched)
+                std::cout << "Replay matched the recording for all " << tick << " ticks" << std::endl;
+
+            unsimulatedTime -= TICK_LENGTH;
         }
 
-        Orc::preventIntersection(orcs, deltaTime);
+        if (tickCount == MAX_TICKS_PER_FRAME)
+            unsimulatedTime %= TICK_LENGTH;
+
+        // how far between the last two ticks to draw everything
+        float interpolation = unsimulatedTime / TICK_LENGTH;
+
+        SoundManager::get().playQueuedSounds();
 
         window.clear();
 
         sf::Vector2f viewCenter = view.getCenter();
-        sf::Vector2f viewTarget = player.m_position + player.getMovement() * 250.f;
-        viewCenter = viewCenter + (viewTarget - viewCenter) * deltaTime;
+        sf::Vector2f viewTarget = player.getInterpolatedPosition(interpolation) + player.getMovement() * 250.f;
+        viewCenter = viewCenter + (viewTarget - viewCenter) * std::min(frameTime.asSeconds(), 1.f);
         view.setCenter(viewCenter);
 
         window.setView(view);
 
-        map.draw(window);
+        if (simulation.m_world) simulation.m_world->draw(window);
+        else map.draw(window);
+
+        drawQueue.clear();
 
-        player.draw(window);
-        
-        for (auto& orc : orcs)
-            orc.draw(window);
+        player.draw(drawQueue, interpolation);
+
+        orcs.draw(drawQueue, interpolation);
+
+        // every character is on the same atlas page, so this is normally a single draw call
+        spriteBatch.clear(getViewBounds(view));
+        drawQueue.emit(spriteBatch);
+        spriteBatch.draw(window);
 
         window.display();
 
@@ -170,4 +205,6 @@ int main() {
 
         lastFrameStart = currentFrameStart;
     }
+
+    if (!recordPath.empty()) recording.saveToFile(recordPath);
 }
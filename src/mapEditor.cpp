@@ -1,5 +1,7 @@
 #include <SFML/Graphics.hpp>
 #include <tileSet.hpp>
+#include <hierarchicalPathfinder.hpp>
+#include <optional>
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -36,7 +38,6 @@ int main(int argc, const char** argv) {
     for (cell.y = 0; cell.y < tileSetRows; cell.y++) {
         tileSet[cell] = cell.x + cell.y * tileSetColumns;
     }
-    tileSet.updateVertices();
 
     TileSet map;
 
@@ -56,6 +57,15 @@ int main(int argc, const char** argv) {
 
     sf::Vector2i currentBrush { 0, 0 };
 
+    // P and O set the ends of a preview path, which is found again whenever the walls change
+    HierarchicalPathfinder pathfinder;
+    sf::Vector2i pathStart { -1, -1 };
+    sf::Vector2i pathGoal { -1, -1 };
+    std::vector<sf::Vector2i> path;
+    bool pathOutOfDate = false;
+    // a rebuild of the whole graph can leave a request for the next frame
+    std::optional<HierarchicalPathfinder::RequestId> pathRequest;
+
     while (window.isOpen()) {
         sf::Vector2f mousePosition { sf::Mouse::getPosition(window) };
         sf::Vector2i currentTile = tileSet.getCellAtPosition(mousePosition);
@@ -76,7 +86,16 @@ int main(int argc, const char** argv) {
         case sf::Event::KeyPressed:
             switch (event.key.scancode) {
             case sf::Keyboard::Scancode::S:
-                map.saveToFile(mapLayoutPath);
+                // shift saves runs of a tile as tile*count, which only this game's loaders read
+                map.saveToFile(mapLayoutPath, event.key.shift);
+                break;
+            case sf::Keyboard::Scancode::P:
+                if (mouseOnMap) pathStart = currentCell;
+                pathOutOfDate = true;
+                break;
+            case sf::Keyboard::Scancode::O:
+                if (mouseOnMap) pathGoal = currentCell;
+                pathOutOfDate = true;
                 break;
             default: break;
             }
@@ -90,14 +109,35 @@ int main(int argc, const char** argv) {
                     map.removeWallType(type);
                 else
                     map.addWallType(type);
+
+                pathOutOfDate = true;
             }
             break;
         default: break;
         }
 
         if (sf::Mouse::isButtonPressed(sf::Mouse::Left) && mouseOnMap) {
-            map[currentCell] = tileSet[currentBrush];
-            map.updateVertices();
+            int type = tileSet.getCellType(currentBrush);
+
+            if (map.getCellType(currentCell) != type) {
+                map[currentCell] = type;
+                pathfinder.invalidateCell(currentCell);
+                pathOutOfDate = true;
+            }
+        }
+
+        if (pathOutOfDate && !pathRequest && map.isOnTileSet(pathStart) && map.isOnTileSet(pathGoal)) {
+            pathRequest = pathfinder.requestPath(pathStart, pathGoal);
+            pathOutOfDate = false;
+        }
+
+        if (pathRequest) {
+            pathfinder.processRequests(map, sf::milliseconds(2));
+
+            if (auto found = pathfinder.takePath(*pathRequest)) {
+                path = std::move(*found);
+                pathRequest.reset();
+            }
         }
 
         sf::Time currentFrameStart = clock.getElapsedTime();
@@ -118,6 +158,12 @@ int main(int argc, const char** argv) {
 
         map.draw(window);
 
+        for (auto& pathCell : path)
+            map.highlightCell(window, pathCell, { 255, 255, 0, 50 });
+
+        if (map.isOnTileSet(pathStart)) map.highlightCell(window, pathStart, { 0, 255, 0, 100 });
+        if (map.isOnTileSet(pathGoal)) map.highlightCell(window, pathGoal, { 0, 0, 255, 100 });
+
         if (mouseOnMap) map.highlightCell(window, currentCell, { 255, 0, 0, 50 });
 
         sf::View UIview = view;
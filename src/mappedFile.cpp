@@ -0,0 +1,97 @@
+#include <mappedFile.hpp>
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.good())
+        throw std::runtime_error("Could not open file: " + filename);
+
+    m_buffer.assign(std::istreambuf_iterator<char>(file), {});
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+}
+
+void MappedFile::unmap() {
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open file: " + filename);
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not stat file: " + filename);
+    }
+
+    m_size = static_cast<std::size_t>(info.st_size);
+
+    // mmap refuses zero length mappings, an empty file is just an empty view
+    if (m_size > 0) {
+        void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Could not map file: " + filename);
+        }
+
+        ::madvise(mapping, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(mapping);
+    }
+
+    ::close(fd);
+}
+
+void MappedFile::unmap() {
+    if (m_data) ::munmap(const_cast<char*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+
+    unmap();
+
+#ifdef _WIN32
+    m_buffer = std::move(other.m_buffer);
+    m_data = m_buffer.data();
+#else
+    m_data = other.m_data;
+#endif
+    m_size = other.m_size;
+
+    other.m_data = nullptr;
+    other.m_size = 0;
+
+    return *this;
+}
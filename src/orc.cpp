@@ -1,202 +1,323 @@
 #include <orc.hpp>
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 
-Orc::Resources Orc::Resources::s_singleton {};
-
-Orc::Orc() :
-    m_idleSpriteSheet(
-        Resources::get().idleSpriteSheetTexture(),
-        1, 16, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } }
-    ),
-    m_walkSpriteSheet(
-        Resources::get().walkSpriteSheetTexture(),
-        1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } }
-    ),
-    m_damageSpriteSheet(
-        Resources::get().damageSpriteSheetTexture(),
-        1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } }
-    ),
-    m_attackSpriteSheet(
-        Resources::get().attackSpriteSheetTexture(),
-        1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } }
-    )
-{
-    m_idleSpriteSheet.m_sprite.setScale({ 5.f, 5.f });
-    m_idleSpriteSheet.m_animationSpeed = 5.f;
-    
-    m_walkSpriteSheet.m_sprite.setScale({ 5.f, 5.f });
-    m_walkSpriteSheet.m_animationSpeed = 5.f;
-    
-    m_damageSpriteSheet.m_sprite.setScale({ 5.f, 5.f });
-    m_damageSpriteSheet.m_animationSpeed = 10.f;
-    m_damageSpriteSheet.m_loop = false;
-    
-    m_attackSpriteSheet.m_sprite.setScale({ 5.f, 5.f });
-    m_attackSpriteSheet.m_animationSpeed = 10.f;
-    m_attackSpriteSheet.m_loop = false;
-}
-
-void Orc::preventIntersection(std::vector<Orc>& orcs, float deltaTime) {
-    for (int i = 0; i + 1 < orcs.size(); i++)
-    for (int j = i + 1; j < orcs.size(); j++) {
-        Orc& orc1 = orcs[i];
-        Orc& orc2 = orcs[j];
-
-        const sf::FloatRect& orc1Bounds = orc1.getBounds();
-        const sf::FloatRect& orc2Bounds = orc2.getBounds();
-
-        if (orc1Bounds.intersects(orc2Bounds)) {
-            sf::Vector2f deltaPosition = orc2.m_position - orc1.m_position;
-
-            deltaPosition.x = deltaPosition.x > 0.f ?
-                orc1Bounds.left + orc1Bounds.width - orc2Bounds.left :
-                orc2Bounds.left + orc2Bounds.width - orc1Bounds.left ;
-            
-            deltaPosition.y = deltaPosition.y > 0.f ?
-                orc1Bounds.top + orc1Bounds.height - orc2Bounds.top :
-                orc2Bounds.top + orc2Bounds.height - orc1Bounds.top ;
-            
-            if (std::abs(deltaPosition.x) > std::abs(deltaPosition.y))
-                deltaPosition.x = 0.f;
-            else
-                deltaPosition.y = 0.f;
-
-            orc1.m_position += deltaPosition * deltaTime * 15.f;
-            orc2.m_position -= deltaPosition * deltaTime * 15.f;
-        }
-    }
+OrcStore::Resources OrcStore::Resources::s_singleton {};
+
+void OrcStore::Resources::loadSpriteSheets() {
+    m_spriteSheets[e_OrcIdle] = SpriteSheet(*r_idleSpriteSheet, 1, 16, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } });
+    m_spriteSheets[e_OrcWalk] = SpriteSheet(*r_walkSpriteSheet, 1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } });
+    m_spriteSheets[e_OrcDamage] = SpriteSheet(*r_damageSpriteSheet, 1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } });
+    m_spriteSheets[e_OrcAttack] = SpriteSheet(*r_attackSpriteSheet, 1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } });
+
+    for (auto& spriteSheet : m_spriteSheets)
+        spriteSheet.m_sprite.setScale({ 5.f, 5.f });
+
+    m_spriteSheets[e_OrcIdle].m_animationSpeed = 5.f;
+    m_spriteSheets[e_OrcWalk].m_animationSpeed = 5.f;
+
+    m_spriteSheets[e_OrcDamage].m_animationSpeed = 10.f;
+    m_spriteSheets[e_OrcDamage].m_loop = false;
+
+    m_spriteSheets[e_OrcAttack].m_animationSpeed = 10.f;
+    m_spriteSheets[e_OrcAttack].m_loop = false;
 }
 
-sf::Vector2f Orc::getFacingDirection() {
-    static bool facingRight = true;
-    static bool facingForward = true;
+std::size_t OrcStore::add(sf::Vector2f position) {
+    // load the shared sprite sheets with the first orc, rather than at start up
+    Resources::get();
 
-    facingRight   = (facingRight   || m_movement.x > s_movementThreshold) && (m_movement.x >= -s_movementThreshold);
-    facingForward = (facingForward || m_movement.y > s_movementThreshold) && (m_movement.y >= -s_movementThreshold);
+    m_positions.push_back(position);
+    m_previousPositions.push_back(position);
+    m_movements.push_back({});
+    m_health.push_back(s_maxHealth);
+    m_attackCooldowns.push_back(0.f);
+    m_states.push_back(e_FacingRight | e_FacingForward);
 
-    return {
-        facingRight ? 1.f : -1.f,
-        facingForward ? 1.f : -1.f
-    };
+    for (auto& indices : m_animationIndices)
+        indices.push_back(0.f);
+
+    return m_positions.size() - 1;
 }
 
-sf::FloatRect Orc::getBounds() {
-    return {
-        { m_position.x - 15.f, m_position.y - 15.f },
-        { 30.f, 30.f }
+void OrcStore::remove(std::size_t orc) {
+    auto swapAndPop = [orc](auto& component) {
+        component[orc] = component.back();
+        component.pop_back();
     };
+
+    swapAndPop(m_positions);
+    swapAndPop(m_previousPositions);
+    swapAndPop(m_movements);
+    swapAndPop(m_health);
+    swapAndPop(m_attackCooldowns);
+    swapAndPop(m_states);
+
+    for (auto& indices : m_animationIndices)
+        swapAndPop(indices);
 }
 
-SpriteSheet& Orc::getCurrentSpriteSheet() {
-    return
-        m_takingDamage   ? m_damageSpriteSheet :
-        m_attacking      ? m_attackSpriteSheet :
-        m_moving         ? m_walkSpriteSheet   :
-                           m_idleSpriteSheet   ;
+void OrcStore::clear() {
+    m_positions.clear();
+    m_previousPositions.clear();
+    m_movements.clear();
+    m_health.clear();
+    m_attackCooldowns.clear();
+    m_states.clear();
+
+    for (auto& indices : m_animationIndices)
+        indices.clear();
 }
 
-void Orc::updateAnimation(float deltaTime) {
-    static bool hadFootDown = false;
-    
-    m_moving = std::sqrt(m_movement.x * m_movement.x + m_movement.y * m_movement.y) >= s_movementThreshold;
+void OrcStore::writeSnapshot(SnapshotWriter& writer) const {
+    writer.writeArray<sf::Vector2f>(m_positions);
+    writer.writeArray<sf::Vector2f>(m_previousPositions);
+    writer.writeArray<sf::Vector2f>(m_movements);
+    writer.writeArray<float>(m_health);
+    writer.writeArray<float>(m_attackCooldowns);
+    writer.writeArray<std::uint8_t>(m_states);
 
-    bool footDown = m_moving && (m_walkSpriteSheet.getIndex() % 2 == 1);
+    for (auto& indices : m_animationIndices)
+        writer.writeArray<float>(indices);
+}
 
-    if (footDown && !hadFootDown)
-        SoundManager::get().playSound(Resources::get().stepSound());
+OrcStore::Snapshot OrcStore::readSnapshot(SnapshotReader& reader) {
+    Snapshot snapshot;
+
+    reader.readArray(snapshot.m_positions);
+    reader.readArray(snapshot.m_previousPositions);
+    reader.readArray(snapshot.m_movements);
+    reader.readArray(snapshot.m_health);
+    reader.readArray(snapshot.m_attackCooldowns);
+    reader.readArray(snapshot.m_states);
+
+    std::size_t count = snapshot.m_positions.size();
+    bool sizesMatch = snapshot.m_previousPositions.size() == count
+                   && snapshot.m_movements.size() == count
+                   && snapshot.m_health.size() == count
+                   && snapshot.m_attackCooldowns.size() == count
+                   && snapshot.m_states.size() == count;
+
+    for (auto& indices : snapshot.m_animationIndices) {
+        reader.readArray(indices);
+        sizesMatch &= indices.size() == count;
+    }
 
-    sf::Vector2f facingDirection = getFacingDirection();
-    float animationIndex = ((facingDirection.y < 0.f) << 1u) | (facingDirection.x < 0.f);
-    m_idleSpriteSheet.m_animationRegion.top = animationIndex / 4.f;
-    m_walkSpriteSheet.m_animationRegion.top = animationIndex / 4.f;
-    m_damageSpriteSheet.m_animationRegion.top = animationIndex / 4.f;
-    m_attackSpriteSheet.m_animationRegion.top = animationIndex / 4.f;
+    if (!sizesMatch)
+        throw std::runtime_error("Snapshot has orc components of different lengths");
 
-    m_idleSpriteSheet.incrementIndex(deltaTime);
-    m_walkSpriteSheet.incrementIndex(deltaTime);
-    m_damageSpriteSheet.incrementIndex(deltaTime);
-    m_attackSpriteSheet.incrementIndex(deltaTime);
+    return snapshot;
+}
 
-    m_takingDamage &= !m_damageSpriteSheet.hasFinished();
-    m_attacking &= !m_attackSpriteSheet.hasFinished();
+void OrcStore::restoreSnapshot(Snapshot snapshot) {
+    m_positions = std::move(snapshot.m_positions);
+    m_previousPositions = std::move(snapshot.m_previousPositions);
+    m_movements = std::move(snapshot.m_movements);
+    m_health = std::move(snapshot.m_health);
+    m_attackCooldowns = std::move(snapshot.m_attackCooldowns);
+    m_states = std::move(snapshot.m_states);
 
-    if (!m_takingDamage) m_damageSpriteSheet.setIndex(0);
-    if (!m_attacking)    m_attackSpriteSheet.setIndex(0);
-    if (!m_moving)       m_walkSpriteSheet.setIndex(0);
+    for (int animation = 0; animation < e_OrcAnimationCount; animation++)
+        m_animationIndices[animation] = std::move(snapshot.m_animationIndices[animation]);
+}
 
-    if (!(m_takingDamage || m_moving)) m_walkSpriteSheet.setIndex(0);
+void OrcStore::separate(sf::Vector2f& position1, sf::Vector2f& position2, float deltaTime) {
+    const sf::FloatRect& orc1Bounds = getBounds(position1);
+    const sf::FloatRect& orc2Bounds = getBounds(position2);
 
-    m_attackCooldown = std::max(0.f, m_attackCooldown - deltaTime);
+    if (orc1Bounds.intersects(orc2Bounds)) {
+        sf::Vector2f deltaPosition = position2 - position1;
 
-    hadFootDown = footDown;
-}
+        deltaPosition.x = deltaPosition.x > 0.f ?
+            orc1Bounds.left + orc1Bounds.width - orc2Bounds.left :
+            orc2Bounds.left + orc2Bounds.width - orc1Bounds.left ;
 
-bool Orc::runTowards(sf::Vector2f target) {
-    sf::Vector2f diff = target - m_position;
+        deltaPosition.y = deltaPosition.y > 0.f ?
+            orc1Bounds.top + orc1Bounds.height - orc2Bounds.top :
+            orc2Bounds.top + orc2Bounds.height - orc1Bounds.top ;
 
-    float length = std::sqrt(
-        diff.x * diff.x +
-        diff.y * diff.y);
+        if (std::abs(deltaPosition.x) > std::abs(deltaPosition.y))
+            deltaPosition.x = 0.f;
+        else
+            deltaPosition.y = 0.f;
 
-    if (length > 100.f) {
-        m_movement = diff / length;
-        return false;
-    } else {
-        m_movement *= 0.9f;
-        return true;
+        position1 += deltaPosition * deltaTime * 15.f;
+        position2 -= deltaPosition * deltaTime * 15.f;
     }
 }
 
-void Orc::movementUpdate(float deltaTime) {
-    m_position += m_movement * m_movementSpeed * deltaTime;
+void OrcStore::preventIntersection(std::span<sf::Vector2f> positions, float deltaTime, SpatialHash& broadphase) {
+    broadphase.rebuild(positions);
+
+    // later orcs that started the frame in the cells around each one, in order, so pairs are
+    // separated in the same order as testing every pair would
+    for (size_t i = 0; i + 1 < positions.size(); i++)
+    for (std::uint32_t j : broadphase.getLaterNeighbours(i))
+        separate(positions[i], positions[j], deltaTime);
+}
+
+void OrcStore::tileSetCollisionUpdate(const TileSet& tileSet) {
+    JobSystem::get().parallelFor(size(), s_minimumJobSize, [&](std::size_t begin, std::size_t end) {
+        tileSet.resolveCollisions(std::span(m_positions).subspan(begin, end - begin), s_halfExtent);
+    });
+}
+
+void OrcStore::tileSetCollisionUpdate(const PagedWorld& world) {
+    JobSystem::get().parallelFor(size(), s_minimumJobSize, [&](std::size_t begin, std::size_t end) {
+        world.resolveCollisions(std::span(m_positions).subspan(begin, end - begin), s_halfExtent);
+    });
+}
+
+OrcAnimation OrcStore::getCurrentAnimation(std::size_t orc) const {
+    std::uint8_t state = m_states[orc];
+
+    return
+        state & e_TakingDamage ? e_OrcDamage :
+        state & e_Attacking    ? e_OrcAttack :
+        state & e_Moving       ? e_OrcWalk   :
+                                 e_OrcIdle   ;
 }
 
-void Orc::tileSetCollisionUpdate(TileSet& tileSet) {
-    sf::FloatRect bounds = getBounds();
+SpriteSheet& OrcStore::poseSpriteSheet(std::size_t orc, float interpolation) {
+    OrcAnimation animation = getCurrentAnimation(orc);
+    SpriteSheet& spriteSheet = Resources::get().spriteSheet(animation);
 
-    sf::Vector2i offset, orcCell = tileSet.getCellAtPosition(m_position);
-    for (offset.y = -1; offset.y <= 1; offset.y++)
-    for (offset.x = -1; offset.x <= 1; offset.x++)
-    if (!(offset.x && offset.y)) {
-        sf::Vector2i cell = orcCell + offset;
+    std::uint8_t state = m_states[orc];
+    float rowIndex = (!(state & e_FacingForward) << 1u) | !(state & e_FacingRight);
+    spriteSheet.m_animationRegion.top = rowIndex / 4.f;
+    spriteSheet.setIndex(m_animationIndices[animation][orc]);
+
+    sf::Vector2f previousPosition = m_previousPositions[orc];
+    spriteSheet.m_sprite.setPosition(previousPosition + (m_positions[orc] - previousPosition) * interpolation);
+    return spriteSheet;
+}
 
-        sf::FloatRect tileBounds = tileSet.getCellBounds(cell);
+void OrcStore::steerTowards(sf::Vector2f target, float deltaTime, const FlowField* flowField) {
+    SteeringKernel::Parameters parameters {
+        target,
+        s_attackRange,
+        s_arrivedDamping,
+        s_movementSpeed,
+        deltaTime,
+        e_Attacking,
+        e_ReachedTarget
+    };
+
+    if (flowField) m_directions.resize(size());
+
+    JobSystem::get().parallelFor(size(), s_minimumJobSize, [&](std::size_t begin, std::size_t end) {
+        if (flowField)
+            for (size_t i = begin; i < end; i++)
+                m_directions[i] = flowField->getDirection(m_positions[i]);
+
+        SteeringKernel::steerTowards(
+            m_positions.data() + begin,
+            m_movements.data() + begin,
+            m_states.data() + begin,
+            end - begin,
+            parameters,
+            flowField ? m_directions.data() + begin : nullptr);
+    });
+}
 
-        if (tileSet.isWallType(tileSet.getCellType(cell)) && bounds.intersects(tileBounds)) {
-            sf::Vector2f tileCentre = tileBounds.getPosition() + tileBounds.getSize() * 0.5f;
-            sf::Vector2f deltaPosition = m_position - tileCentre;
+void OrcStore::updateAnimation(float deltaTime) {
+    Resources& resources = Resources::get();
 
-            if (std::abs(deltaPosition.x) > std::abs(deltaPosition.y)) {
-                if (m_position.x < tileCentre.x) m_position.x = tileBounds.left - bounds.width * 0.5f;
-                else m_position.x = tileBounds.left + tileBounds.width + bounds.width * 0.5f;
-            } else {
-                if (m_position.y < tileCentre.y) m_position.y = tileBounds.top - bounds.height * 0.5f;
-                else m_position.y = tileBounds.top + tileBounds.height + bounds.height * 0.5f;
+    const SpriteSheet& damageSpriteSheet = resources.spriteSheet(e_OrcDamage);
+    const SpriteSheet& attackSpriteSheet = resources.spriteSheet(e_OrcAttack);
+
+    JobSystem::get().parallelFor(size(), s_minimumJobSize, [&](std::size_t begin, std::size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            sf::Vector2f movement = m_movements[i];
+            std::uint8_t state = m_states[i];
+
+            bool moving = std::sqrt(movement.x * movement.x + movement.y * movement.y) >= s_movementThreshold;
+            bool footDown = moving && (static_cast<int>(std::floor(m_animationIndices[e_OrcWalk][i])) % 2 == 1);
+
+            if (footDown && !(state & e_FootDown))
+                SoundQueue::get().push(e_OrcStepSound);
+
+            bool facingRight   = (state & e_FacingRight   || movement.x > s_movementThreshold) && (movement.x >= -s_movementThreshold);
+            bool facingForward = (state & e_FacingForward || movement.y > s_movementThreshold) && (movement.y >= -s_movementThreshold);
+
+            for (int animation = 0; animation < e_OrcAnimationCount; animation++) {
+                float& index = m_animationIndices[animation][i];
+                index = resources.spriteSheet(static_cast<OrcAnimation>(animation)).getNextIndex(index, deltaTime);
             }
+
+            bool takingDamage = state & e_TakingDamage && !damageSpriteSheet.hasFinished(m_animationIndices[e_OrcDamage][i]);
+            bool attacking = state & e_Attacking && !attackSpriteSheet.hasFinished(m_animationIndices[e_OrcAttack][i]);
+
+            if (!takingDamage) m_animationIndices[e_OrcDamage][i] = 0.f;
+            if (!attacking)    m_animationIndices[e_OrcAttack][i] = 0.f;
+            if (!moving)       m_animationIndices[e_OrcWalk][i] = 0.f;
+
+            m_attackCooldowns[i] = std::max(0.f, m_attackCooldowns[i] - deltaTime);
+
+            m_states[i] = (state & e_ReachedTarget)
+                        | (moving        ? e_Moving        : 0)
+                        | (attacking     ? e_Attacking     : 0)
+                        | (takingDamage  ? e_TakingDamage  : 0)
+                        | (facingRight   ? e_FacingRight   : 0)
+                        | (facingForward ? e_FacingForward : 0)
+                        | (footDown      ? e_FootDown      : 0);
         }
-    }
+    });
 }
 
-void Orc::draw(sf::RenderTarget& renderTarget) {
-    SpriteSheet& spriteSheet = getCurrentSpriteSheet();
-    spriteSheet.m_sprite.setPosition(m_position);
-    spriteSheet.draw(renderTarget);
+void OrcStore::attackUpdate() {
+    JobSystem::get().parallelFor(size(), s_minimumJobSize, [&](std::size_t begin, std::size_t end) {
+        for (size_t i = begin; i < end; i++)
+            if (hasReachedTarget(i) && canAttack(i))
+                attack(i);
+    });
 }
 
-void Orc::takeDamage(float damage) {
-    m_health -= damage;
+void OrcStore::takeSwordHits(const Player& player, float damage) {
+    auto swordBounds = player.getSwordBounds();
+    if (!swordBounds) return;
+
+    JobSystem::get().parallelFor(size(), s_minimumJobSize, [&](std::size_t begin, std::size_t end) {
+        for (size_t i = begin; i < end; i++)
+            if (canTakeDamage(i) && swordBounds->intersects(getBounds(i)))
+                takeDamage(i, damage);
+    });
+}
 
-    m_takingDamage = true;
-    SoundManager::get().playSound(Resources::get().damageSound());
+void OrcStore::removeDead() {
+    // from the back, so the orcs swapped into their places have already been checked
+    for (std::size_t i = size(); i-- > 0;)
+        if (!isAlive(i)) remove(i);
 }
 
-void Orc::attack() {
-    if (!canAttack()) return;
+void OrcStore::draw(sf::RenderTarget& renderTarget, float interpolation) {
+    for (size_t i = 0; i < size(); i++) {
+        SpriteSheet& spriteSheet = poseSpriteSheet(i, interpolation);
+        spriteSheet.draw(renderTarget);
+    }
+}
 
-    m_attacking = true;
-    SoundManager::get().playSound(Resources::get().attackSound());
+void OrcStore::draw(DrawQueue& queue, float interpolation) {
+    for (size_t i = 0; i < size(); i++) {
+        SpriteSheet& spriteSheet = poseSpriteSheet(i, interpolation);
+        spriteSheet.draw(queue, e_CharacterLayer, spriteSheet.m_sprite.getPosition().y);
+    }
+}
 
-    m_attackCooldown = s_attackCooldown;
+void OrcStore::takeDamage(std::size_t orc, float damage) {
+    m_health[orc] -= damage;
+    m_states[orc] |= e_TakingDamage;
+    SoundQueue::get().push(e_OrcDamageSound);
 }
 
+void OrcStore::attack(std::size_t orc) {
+    if (!canAttack(orc)) return;
+
+    m_states[orc] |= e_Attacking;
+    SoundQueue::get().push(e_OrcAttackSound);
 
+    m_attackCooldowns[orc] = s_attackCooldown;
+}
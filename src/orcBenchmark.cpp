@@ -0,0 +1,224 @@
+#include <orc.hpp>
+#include <drawQueue.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Testing every pair of orcs, as OrcStore::preventIntersection used to, kept as a baseline.
+namespace legacy {
+
+void preventIntersection(std::span<sf::Vector2f> positions, float deltaTime) {
+    for (size_t i = 0; i + 1 < positions.size(); i++)
+    for (size_t j = i + 1; j < positions.size(); j++)
+        OrcStore::separate(positions[i], positions[j], deltaTime);
+}
+
+}
+
+// A crowd about as dense as orcs get when they mob the player
+std::vector<sf::Vector2f> generateCrowd(std::size_t count) {
+    std::mt19937 random(1234);
+    float side = std::sqrt(static_cast<float>(count)) * 40.f;
+    std::uniform_real_distribution<float> coordinate(0.f, side);
+
+    std::vector<sf::Vector2f> positions(count);
+    for (auto& position : positions) position = { coordinate(random), coordinate(random) };
+
+    return positions;
+}
+
+float getMaxDifference(const std::vector<sf::Vector2f>& a, const std::vector<sf::Vector2f>& b) {
+    float maxDifference = 0.f;
+
+    for (std::size_t i = 0; i < a.size(); i++) {
+        sf::Vector2f difference = a[i] - b[i];
+        maxDifference = std::max({ maxDifference, std::abs(difference.x), std::abs(difference.y) });
+    }
+
+    return maxDifference;
+}
+
+double timePerFrame(int frames, const std::function<void()>& run) {
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) run();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 10;
+    constexpr float deltaTime = 1.f / 60.f;
+
+    std::cout << "preventIntersection, per frame" << std::endl;
+
+    for (std::size_t count : { 100, 1000, 10000 }) {
+        std::vector<sf::Vector2f> crowd = generateCrowd(count);
+
+        std::vector<sf::Vector2f> bruteForce = crowd;
+        double bruteForceSeconds = timePerFrame(frames, [&]() {
+            legacy::preventIntersection(bruteForce, deltaTime);
+        });
+
+        std::vector<sf::Vector2f> hashed = crowd;
+        SpatialHash broadphase { OrcStore::s_broadphaseCellSize };
+        double hashedSeconds = timePerFrame(frames, [&]() {
+            OrcStore::preventIntersection(hashed, deltaTime, broadphase);
+        });
+
+        float maxDifference = getMaxDifference(hashed, bruteForce);
+
+        std::cout << "  " << count << " orcs: "
+                  << "brute force " << bruteForceSeconds * 1000.0 << " ms, "
+                  << "spatial hash " << hashedSeconds * 1000.0 << " ms, "
+                  << bruteForceSeconds / hashedSeconds << "x"
+                  << " (max difference " << maxDifference << ")" << std::endl;
+    }
+
+    std::cout << "SteeringKernel::steerTowards, per frame" << std::endl;
+
+    for (std::size_t count : { 1000, 10000, 100000 }) {
+        std::vector<sf::Vector2f> crowd = generateCrowd(count);
+
+        // the target is in the middle of the crowd, so some orcs arrive and some keep walking
+        SteeringKernel::Parameters parameters { crowd[count / 2], 100.f, 0.9f, 200.f, deltaTime, 1 << 1, 1 << 6 };
+
+        std::vector<std::uint8_t> startFlags(count);
+        for (std::size_t i = 0; i < count; i++) startFlags[i] = i % 5 == 0 ? parameters.m_frozenFlags : 0;
+
+        // as if from a flow field, any unit vectors will do
+        std::vector<sf::Vector2f> flowDirections(count);
+        for (std::size_t i = 0; i < count; i++)
+            flowDirections[i] = { std::cos(i * 0.1f), std::sin(i * 0.1f) };
+
+        for (bool useDirections : { false, true }) {
+            const sf::Vector2f* directions = useDirections ? flowDirections.data() : nullptr;
+            const char* name = useDirections ? "flow directions" : "straight";
+
+            std::vector<sf::Vector2f> scalarPositions, scalarMovements;
+            std::vector<std::uint8_t> scalarFlags;
+
+            for (auto implementation : {
+                SteeringKernel::Implementation::Scalar,
+                SteeringKernel::Implementation::SSE2,
+                SteeringKernel::Implementation::AVX2
+            }) {
+                if (!SteeringKernel::isSupported(implementation)) {
+                    std::cout << "  " << count << " orcs, " << name << ", " << SteeringKernel::getName(implementation) << ": unsupported" << std::endl;
+                    continue;
+                }
+
+                std::vector<sf::Vector2f> positions = crowd;
+                std::vector<sf::Vector2f> movements(count);
+                std::vector<std::uint8_t> flags = startFlags;
+
+                double seconds = timePerFrame(frames * 10, [&]() {
+                    SteeringKernel::steerTowards(positions.data(), movements.data(), flags.data(), count, parameters, directions, implementation);
+                });
+
+                if (implementation == SteeringKernel::Implementation::Scalar) {
+                    scalarPositions = positions;
+                    scalarMovements = movements;
+                    scalarFlags = flags;
+                }
+
+                if (flags != scalarFlags)
+                    throw std::runtime_error(std::string("Arrived flags mismatch for ") + SteeringKernel::getName(implementation));
+
+                float maxDifference = std::max(
+                    getMaxDifference(positions, scalarPositions),
+                    getMaxDifference(movements, scalarMovements));
+
+                std::cout << "  " << count << " orcs, " << name << ", " << SteeringKernel::getName(implementation) << ": "
+                          << seconds * 1000.0 << " ms"
+                          << " (max difference from scalar " << maxDifference << ")" << std::endl;
+            }
+        }
+    }
+
+    std::cout << "OrcStore snapshots" << std::endl;
+
+    for (std::size_t count : { 10000, 100000 }) {
+        std::vector<sf::Vector2f> crowd = generateCrowd(count);
+
+        // filled from a hand written snapshot, so no orc resources need loading
+        std::vector<char> initial;
+        SnapshotWriter writer { initial };
+        writer.writeArray<sf::Vector2f>(crowd);
+        writer.writeArray<sf::Vector2f>(crowd);
+        writer.writeArray<sf::Vector2f>(std::vector<sf::Vector2f>(count));
+        writer.writeArray<float>(std::vector<float>(count, 10.f));
+        writer.writeArray<float>(std::vector<float>(count));
+        writer.writeArray<std::uint8_t>(std::vector<std::uint8_t>(count));
+
+        for (int animation = 0; animation < e_OrcAnimationCount; animation++)
+            writer.writeArray<float>(std::vector<float>(count));
+
+        OrcStore orcs;
+        SnapshotReader initialReader { initial };
+        orcs.restoreSnapshot(OrcStore::readSnapshot(initialReader));
+
+        std::vector<char> saved;
+        double saveSeconds = timePerFrame(frames * 10, [&]() {
+            saved.clear();
+            SnapshotWriter savedWriter { saved };
+            orcs.writeSnapshot(savedWriter);
+        });
+
+        double restoreSeconds = timePerFrame(frames * 10, [&]() {
+            SnapshotReader savedReader { saved };
+            orcs.restoreSnapshot(OrcStore::readSnapshot(savedReader));
+        });
+
+        if (saved != initial)
+            throw std::runtime_error("Snapshot of " + std::to_string(count) + " orcs didn't round trip");
+
+        std::cout << "  " << count << " orcs, " << saved.size() << " bytes: "
+                  << "save " << saveSeconds * 1000.0 << " ms, "
+                  << "restore " << restoreSeconds * 1000.0 << " ms" << std::endl;
+    }
+
+    std::cout << "DrawQueue::sort, per frame including submission" << std::endl;
+
+    for (std::size_t count : { 1000, 10000, 100000 }) {
+        // whole numbered depths, some negative, so plenty of sprites tie and stability matters
+        std::mt19937 random(1234);
+        std::uniform_int_distribution<int> layer(e_GroundLayer, e_OverlayLayer);
+        std::uniform_int_distribution<int> depth(-500, 500);
+
+        std::vector<std::pair<std::uint32_t, float>> keys(count);
+        for (auto& key : keys) key = { layer(random), static_cast<float>(depth(random)) };
+
+        sf::Sprite sprite;
+        DrawQueue queue;
+        double radixSeconds = timePerFrame(frames * 10, [&]() {
+            queue.clear();
+            for (auto& [keyLayer, keyDepth] : keys) queue.submit(keyLayer, keyDepth, sprite);
+            queue.sort();
+        });
+
+        std::vector<std::uint32_t> order(count);
+        double stableSortSeconds = timePerFrame(frames * 10, [&]() {
+            for (std::uint32_t i = 0; i < count; i++) order[i] = i;
+
+            std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+                return keys[a] < keys[b];
+            });
+        });
+
+        for (std::size_t i = 0; i < count; i++)
+            if (queue.getSubmissionAt(i) != order[i])
+                throw std::runtime_error("DrawQueue order differs from std::stable_sort at " + std::to_string(i));
+
+        std::cout << "  " << count << " sprites: "
+                  << "std::stable_sort " << stableSortSeconds * 1000.0 << " ms, "
+                  << "radix sort " << radixSeconds * 1000.0 << " ms, "
+                  << stableSortSeconds / radixSeconds << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,476 @@
+#include <pagedWorld.hpp>
+#include <csvParser.hpp>
+#include <tileCollision.hpp>
+#include <viewBounds.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// World files are the header, the 32 bit wall types, then every region in row major order. Each region
+// is regionSize * regionSize 16 bit cells in row major order, with cells past the edge of the grid empty.
+constexpr char s_worldMagic[4] = { 'S', 'F', 'W', 'D' };
+constexpr std::uint32_t s_worldVersion = 2;
+
+struct WorldHeader {
+    char m_magic[4];
+    std::uint32_t m_version;
+
+    std::int32_t m_regionSize;
+    std::int32_t m_gridColumns;
+    std::int32_t m_gridRows;
+
+    std::uint32_t m_wallTypeCount;
+};
+
+int regionsToCover(int cells, int regionSize) {
+    return (cells + regionSize - 1) / regionSize;
+}
+
+}
+
+void PagedWorld::convertLayout(const std::string& layoutFilename, const std::string& worldFilename, int regionSize) {
+    if (regionSize <= 0)
+        throw std::runtime_error("Region size must be positive: " + std::to_string(regionSize));
+
+    std::ifstream layoutFile(layoutFilename, std::ios::binary);
+    if (!layoutFile.good())
+        throw std::runtime_error("Failed to open tileset layout: " + layoutFilename);
+
+    std::ofstream worldFile(worldFilename, std::ios::binary | std::ios::trunc);
+    if (!worldFile.good())
+        throw std::runtime_error("Could not open file: " + worldFilename);
+
+    WorldHeader header {};
+    std::memcpy(header.m_magic, s_worldMagic, sizeof(s_worldMagic));
+    header.m_version = s_worldVersion;
+    header.m_regionSize = regionSize;
+
+    // one band of regions at a time, padded out to a whole number of regions wide
+    std::vector<TileId> band;
+    int bandRows = 0;
+    int paddedColumns = 0;
+
+    auto writeBand = [&]() {
+        for (int regionX = 0; regionX < paddedColumns / regionSize; regionX++)
+        for (int y = 0; y < regionSize; y++)
+            worldFile.write(reinterpret_cast<const char*>(band.data() + y * paddedColumns + regionX * regionSize),
+                            regionSize * sizeof(TileId));
+
+        std::fill(band.begin(), band.end(), TileLayout::s_emptyTile);
+        bandRows = 0;
+    };
+
+    CSVParser::forEachRow(layoutFile, [&](unsigned int row, std::span<const std::string_view> cells) {
+        auto rowError = [&](const std::string& message) {
+            return std::runtime_error("Layout row " + std::to_string(row) + " " + message + ": " + layoutFilename);
+        };
+
+        if (row == 0) {
+            std::vector<std::int32_t> wallTypes;
+            for (auto cell : cells) wallTypes.push_back(CSVParser::parseCell<int>(cell));
+
+            header.m_wallTypeCount = wallTypes.size();
+            worldFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            worldFile.write(reinterpret_cast<const char*>(wallTypes.data()), wallTypes.size() * sizeof(std::int32_t));
+            return;
+        }
+
+        // every row has to match the first one
+        if (row == 1) {
+            for (auto cell : cells) {
+                TileId tile;
+                std::size_t count;
+                header.m_gridColumns += TileLayout::parseRun(cell, tile, count) ? count : 1;
+            }
+
+            paddedColumns = regionsToCover(header.m_gridColumns, regionSize) * regionSize;
+            band.assign(static_cast<std::size_t>(paddedColumns) * regionSize, TileLayout::s_emptyTile);
+        }
+
+        TileId* bandRow = band.data() + static_cast<std::size_t>(bandRows) * paddedColumns;
+        std::size_t column = 0;
+        std::size_t gridColumns = static_cast<std::size_t>(header.m_gridColumns);
+
+        for (auto cell : cells) {
+            TileId tile;
+            std::size_t count;
+
+            if (!TileLayout::parseRun(cell, tile, count))
+                throw rowError("cell " + std::to_string(column) + " is not a tile index");
+
+            if (column + count > gridColumns)
+                throw rowError("has more than " + std::to_string(header.m_gridColumns) + " cells");
+
+            std::fill_n(bandRow + column, count, tile);
+            column += count;
+        }
+
+        if (column != gridColumns)
+            throw rowError("has " + std::to_string(column) + " cells, expected " + std::to_string(header.m_gridColumns));
+
+        header.m_gridRows++;
+        if (++bandRows == regionSize) writeBand();
+    });
+
+    if (bandRows > 0) writeBand();
+
+    // the grid's size is only known now it's all been read
+    worldFile.seekp(0);
+    worldFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!worldFile.good())
+        throw std::runtime_error("Failed to write world: " + worldFilename);
+}
+
+bool PagedWorld::isWorldFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+
+    char magic[sizeof(s_worldMagic)] {};
+    file.read(magic, sizeof(magic));
+
+    return file.good() && std::memcmp(magic, s_worldMagic, sizeof(s_worldMagic)) == 0;
+}
+
+PagedWorld::PagedWorld(
+    const std::string& textureFilename,
+    int tileSetColumns,
+    int tileSetRows,
+    float scale,
+    const std::string& worldFilename,
+    std::size_t memoryBudget
+)   :
+    m_tileSetColumns(tileSetColumns),
+    m_tileSetRows(tileSetRows),
+    m_file(worldFilename, std::ios::binary)
+{
+    // the atlas isn't safe to use from the loading thread, so the region is looked up here
+    m_atlasRegion = TextureAtlas::get().load(textureFilename);
+    m_buildVertices = !TextureAtlas::get().isHeadless();
+
+    if (!m_file.good())
+        throw std::runtime_error("Could not open file: " + worldFilename);
+
+    WorldHeader header {};
+    m_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!m_file.good() || std::memcmp(header.m_magic, s_worldMagic, sizeof(s_worldMagic)) != 0)
+        throw std::runtime_error("Not a world file: " + worldFilename);
+
+    if (header.m_version != s_worldVersion)
+        throw std::runtime_error(
+            "World file is version " + std::to_string(header.m_version) +
+            ", expected " + std::to_string(s_worldVersion) + ", convert it again: " + worldFilename);
+
+    if (header.m_regionSize <= 0 || header.m_gridColumns < 0 || header.m_gridRows < 0)
+        throw std::runtime_error("World file has negative or empty dimensions: " + worldFilename);
+
+    std::vector<std::int32_t> wallTypes(header.m_wallTypeCount);
+    m_file.read(reinterpret_cast<char*>(wallTypes.data()), wallTypes.size() * sizeof(std::int32_t));
+
+    if (!m_file.good())
+        throw std::runtime_error("World file is truncated: " + worldFilename);
+
+    m_wallTypes.insert(wallTypes.begin(), wallTypes.end());
+
+    m_regionSize = header.m_regionSize;
+    m_gridColumns = header.m_gridColumns;
+    m_gridRows = header.m_gridRows;
+    m_regionColumns = regionsToCover(m_gridColumns, m_regionSize);
+    m_regionRows = regionsToCover(m_gridRows, m_regionSize);
+    m_regionDataStart = m_file.tellg();
+
+    sf::Vector2i textureSize = m_atlasRegion.m_rect.getSize();
+    m_tileSize = {
+        textureSize.x / static_cast<float>(m_tileSetColumns),
+        textureSize.y / static_cast<float>(m_tileSetRows)
+    };
+
+    m_cellSize = m_tileSize * scale;
+
+    // the regions in the load radius are always kept, whatever the budget
+    std::size_t loadDiameter = 2 * s_loadRadius + 1;
+    m_maxLoadedRegions = std::max(memoryBudget / getRegionBytes(), loadDiameter * loadDiameter);
+
+    m_loadingThread = std::thread(&PagedWorld::loadingThreadMain, this);
+}
+
+PagedWorld::~PagedWorld() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_requestsChanged.notify_all();
+    m_loadingThread.join();
+}
+
+std::size_t PagedWorld::getRegionBytes() const {
+    // at most six vertices a cell, empty cells have none
+    std::size_t cellBytes = sizeof(TileId) + sizeof(std::uint8_t) + (m_buildVertices ? 6 * sizeof(sf::Vertex) : 0);
+    return cellBytes * m_regionSize * m_regionSize;
+}
+
+void PagedWorld::loadingThreadMain() {
+    while (true) {
+        std::int64_t index;
+
+        {
+            std::unique_lock lock(m_mutex);
+            m_requestsChanged.wait(lock, [this]() { return m_stopping || !m_requests.empty(); });
+
+            if (m_stopping) return;
+
+            index = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        // a failed load is only reported once, the main thread asks for the region again
+        try {
+            Region region = loadRegion(index);
+
+            std::lock_guard lock(m_mutex);
+            m_loaded.push_back({ index, std::move(region) });
+        } catch (...) {
+            std::lock_guard lock(m_mutex);
+            m_error = std::current_exception();
+        }
+
+        m_regionLoaded.notify_all();
+    }
+}
+
+PagedWorld::Region PagedWorld::loadRegion(std::int64_t index) {
+    std::size_t cellCount = static_cast<std::size_t>(m_regionSize) * m_regionSize;
+
+    Region region;
+    region.m_cells.resize(cellCount);
+
+    // a failed read leaves the stream failed, which would fail every load after it
+    m_file.clear();
+    m_file.seekg(m_regionDataStart + static_cast<std::streamoff>(index * cellCount * sizeof(TileId)));
+    m_file.read(reinterpret_cast<char*>(region.m_cells.data()), cellCount * sizeof(TileId));
+
+    if (!m_file.good())
+        throw std::runtime_error("Failed to read world region " + std::to_string(index));
+
+    region.m_solid.resize(cellCount);
+    for (std::size_t i = 0; i < cellCount; i++)
+        region.m_solid[i] = m_wallTypes.contains(region.m_cells[i]);
+
+    sf::Vector2i regionCoordinates = getRegionCoordinates(index);
+    if (m_buildVertices)
+        buildVertices(region, { regionCoordinates.x * m_regionSize, regionCoordinates.y * m_regionSize });
+
+    return region;
+}
+
+void PagedWorld::buildVertices(Region& region, sf::Vector2i regionCell) const {
+    // the padding past the edge of the grid isn't drawn
+    int columns = std::min(m_regionSize, m_gridColumns - regionCell.x);
+    int rows = std::min(m_regionSize, m_gridRows - regionCell.y);
+
+    for (int y = 0; y < rows; y++)
+    for (int x = 0; x < columns; x++) {
+        TileId tileIndex = region.m_cells[x + y * m_regionSize];
+        if (tileIndex == TileLayout::s_emptyTile) continue;
+
+        sf::Vector2f tile {
+            m_atlasRegion.m_rect.left + (tileIndex % m_tileSetColumns) * m_tileSize.x,
+            m_atlasRegion.m_rect.top + (tileIndex / m_tileSetColumns) * m_tileSize.y
+        };
+        sf::Vector2f cell { (regionCell.x + x) * m_cellSize.x, (regionCell.y + y) * m_cellSize.y };
+
+        sf::Vector2f cellCorners[4] {
+            cell, { cell.x + m_cellSize.x, cell.y }, { cell.x, cell.y + m_cellSize.y }, cell + m_cellSize
+        };
+
+        sf::Vector2f tileCorners[4] {
+            tile, { tile.x + m_tileSize.x, tile.y }, { tile.x, tile.y + m_tileSize.y }, tile + m_tileSize
+        };
+
+        // top left, top right, bottom left, then bottom left, top right, bottom right
+        for (int corner : { 0, 1, 2, 2, 1, 3 })
+            region.m_vertices.append({ cellCorners[corner], tileCorners[corner] });
+    }
+}
+
+void PagedWorld::setFocus(sf::Vector2f position) {
+    sf::Vector2i cell = getCellAtPosition(position);
+
+    // anywhere off the grid counts as the nearest region on it
+    sf::Vector2i focusRegion {
+        std::clamp(cell.x / m_regionSize, 0, std::max(m_regionColumns - 1, 0)),
+        std::clamp(cell.y / m_regionSize, 0, std::max(m_regionRows - 1, 0))
+    };
+
+    if (focusRegion == m_focusRegion) return;
+
+    m_focusRegion = focusRegion;
+    m_requestsStale = true;
+}
+
+void PagedWorld::requestRegions() {
+    std::vector<std::pair<int, std::int64_t>> wanted;
+
+    sf::Vector2i offset;
+    for (offset.y = -s_loadRadius; offset.y <= s_loadRadius; offset.y++)
+    for (offset.x = -s_loadRadius; offset.x <= s_loadRadius; offset.x++) {
+        sf::Vector2i region = m_focusRegion + offset;
+
+        if (region.x < 0 || region.y < 0 || region.x >= m_regionColumns || region.y >= m_regionRows)
+            continue;
+
+        std::int64_t index = getRegionIndex(region);
+        if (!m_regions.contains(index)) wanted.push_back({ offset.x * offset.x + offset.y * offset.y, index });
+    }
+
+    // nearest first, so the active regions come before the ones loaded ahead
+    std::sort(wanted.begin(), wanted.end());
+
+    {
+        // anything still queued for the last focus is no longer needed
+        std::lock_guard lock(m_mutex);
+        m_requests.clear();
+
+        for (auto& [distance, index] : wanted) m_requests.push_back(index);
+    }
+
+    m_requestsChanged.notify_one();
+    m_requestsStale = false;
+}
+
+void PagedWorld::takeLoadedRegions() {
+    std::vector<LoadedRegion> loaded;
+    std::exception_ptr error;
+
+    {
+        std::lock_guard lock(m_mutex);
+        loaded.swap(m_loaded);
+        std::swap(error, m_error);
+    }
+
+    for (auto& [index, region] : loaded)
+        m_regions.try_emplace(index, std::move(region));
+
+    if (error) {
+        m_requestsStale = true;
+        std::rethrow_exception(error);
+    }
+}
+
+bool PagedWorld::areActiveRegionsLoaded() const {
+    sf::Vector2i offset;
+    for (offset.y = -s_activeRadius; offset.y <= s_activeRadius; offset.y++)
+    for (offset.x = -s_activeRadius; offset.x <= s_activeRadius; offset.x++) {
+        sf::Vector2i region = m_focusRegion + offset;
+
+        if (region.x < 0 || region.y < 0 || region.x >= m_regionColumns || region.y >= m_regionRows)
+            continue;
+
+        if (!m_regions.contains(getRegionIndex(region))) return false;
+    }
+
+    return true;
+}
+
+void PagedWorld::evictRegions() {
+    if (m_regions.size() <= m_maxLoadedRegions) return;
+
+    std::vector<std::pair<int, std::int64_t>> byDistance;
+    byDistance.reserve(m_regions.size());
+
+    for (auto& [index, region] : m_regions) {
+        sf::Vector2i offset = getRegionCoordinates(index) - m_focusRegion;
+        byDistance.push_back({ std::max(std::abs(offset.x), std::abs(offset.y)), index });
+    }
+
+    // the budget always covers the load radius, so nothing in it is ever the furthest
+    std::sort(byDistance.begin(), byDistance.end(), std::greater<>());
+
+    for (std::size_t i = 0; m_regions.size() > m_maxLoadedRegions; i++)
+        m_regions.erase(byDistance[i].second);
+}
+
+void PagedWorld::update() {
+    if (m_requestsStale) requestRegions();
+
+    takeLoadedRegions();
+
+    while (!areActiveRegionsLoaded()) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_regionLoaded.wait(lock, [this]() { return !m_loaded.empty() || m_error; });
+        }
+
+        takeLoadedRegions();
+    }
+
+    m_activeRegion = m_focusRegion;
+
+    evictRegions();
+}
+
+bool PagedWorld::isActive(const sf::Vector2i& cell) const {
+    if (cell.x < 0 || cell.y < 0 || cell.x >= m_gridColumns || cell.y >= m_gridRows)
+        return false;
+
+    return std::abs(cell.x / m_regionSize - m_activeRegion.x) <= s_activeRadius
+        && std::abs(cell.y / m_regionSize - m_activeRegion.y) <= s_activeRadius;
+}
+
+const PagedWorld::Region* PagedWorld::findRegion(const sf::Vector2i& cell, int& cellIndex) const {
+    if (!isActive(cell)) return nullptr;
+
+    auto it = m_regions.find(getRegionIndex({ cell.x / m_regionSize, cell.y / m_regionSize }));
+    if (it == m_regions.end()) return nullptr;
+
+    cellIndex = cell.x % m_regionSize + cell.y % m_regionSize * m_regionSize;
+    return &it->second;
+}
+
+int PagedWorld::getCellType(const sf::Vector2i& cell) const {
+    int cellIndex;
+    const Region* region = findRegion(cell, cellIndex);
+    return region ? region->m_cells[cellIndex] : TileLayout::s_emptyTile;
+}
+
+bool PagedWorld::isSolid(const sf::Vector2i& cell) const {
+    int cellIndex;
+    const Region* region = findRegion(cell, cellIndex);
+    return region && region->m_solid[cellIndex];
+}
+
+void PagedWorld::resolveCollisions(std::span<sf::Vector2f> centres, sf::Vector2f halfExtent) const {
+    auto isSolidCell = [this](const sf::Vector2i& cell) { return isSolid(cell); };
+
+    for (auto& centre : centres)
+        resolveTileCollision(centre, halfExtent, m_cellSize, isSolidCell);
+}
+
+void PagedWorld::draw(sf::RenderTarget& target) const {
+    auto states = sf::RenderStates::Default;
+    states.texture = m_atlasRegion.r_texture;
+
+    sf::FloatRect viewBounds = getViewBounds(target.getView());
+    sf::Vector2f regionSize = m_cellSize * static_cast<float>(m_regionSize);
+
+    int firstRegionX = std::max(0, static_cast<int>(std::floor(viewBounds.left / regionSize.x)));
+    int firstRegionY = std::max(0, static_cast<int>(std::floor(viewBounds.top / regionSize.y)));
+    int lastRegionX = std::min(m_regionColumns - 1, static_cast<int>(std::floor((viewBounds.left + viewBounds.width) / regionSize.x)));
+    int lastRegionY = std::min(m_regionRows - 1, static_cast<int>(std::floor((viewBounds.top + viewBounds.height) / regionSize.y)));
+
+    for (int regionY = firstRegionY; regionY <= lastRegionY; regionY++)
+    for (int regionX = firstRegionX; regionX <= lastRegionX; regionX++) {
+        auto it = m_regions.find(getRegionIndex({ regionX, regionY }));
+        if (it != m_regions.end() && it->second.m_vertices.getVertexCount() > 0)
+            target.draw(it->second.m_vertices, states);
+    }
+}
@@ -0,0 +1,252 @@
+#include <hierarchicalPathfinder.hpp>
+#include <textureAtlas.hpp>
+#include <tileSet.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Dijkstra over every cell of the grid, the exact answer the hierarchical search approximates.
+namespace reference {
+
+std::uint32_t findCost(const TileSet& tileSet, const sf::Vector2i& start, const sf::Vector2i& goal) {
+    constexpr std::uint32_t unreachable = std::numeric_limits<std::uint32_t>::max();
+
+    int columns = tileSet.gridColumns();
+    auto isOpen = [&](const sf::Vector2i& cell) { return tileSet.isOnTileSet(cell) && !tileSet.isSolid(cell); };
+    if (!isOpen(start) || !isOpen(goal)) return unreachable;
+
+    std::vector<std::uint32_t> costs(static_cast<std::size_t>(columns) * tileSet.gridRows(), unreachable);
+    std::priority_queue<std::pair<std::uint32_t, int>, std::vector<std::pair<std::uint32_t, int>>, std::greater<>> queue;
+
+    costs[start.x + start.y * columns] = 0;
+    queue.push({ 0, start.x + start.y * columns });
+
+    while (!queue.empty()) {
+        auto [cost, index] = queue.top();
+        queue.pop();
+
+        if (cost > costs[index]) continue;
+
+        sf::Vector2i cell { index % columns, index / columns };
+        if (cell == goal) return cost;
+
+        for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++) {
+            sf::Vector2i next { cell.x + x, cell.y + y };
+            if (next == cell || !isOpen(next)) continue;
+            if (x != 0 && y != 0 && !(isOpen({ next.x, cell.y }) && isOpen({ cell.x, next.y }))) continue;
+
+            std::uint32_t nextCost = cost + (x != 0 && y != 0 ? 14 : 10);
+            if (nextCost < costs[next.x + next.y * columns]) {
+                costs[next.x + next.y * columns] = nextCost;
+                queue.push({ nextCost, next.x + next.y * columns });
+            }
+        }
+    }
+
+    return unreachable;
+}
+
+}
+
+constexpr char s_tileSetPath[] = "../assets/sprites/Minifantasy_Dungeon_v2.2_Free_Version/Minifantasy_Dungeon_Assets/Tileset/Tileset.png";
+constexpr int s_floorType = 1;
+constexpr int s_wallType = 2;
+// Starts out as floor, the stale graph checks turn it into a wall type
+constexpr int s_laterWallType = 3;
+
+// Scattered walls and a few long ones with gaps, so paths have to wind between clusters
+TileSet generateMap(int columns, int rows) {
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    TileSet tileSet { s_tileSetPath, 23, 14, 1.f, columns, rows };
+    tileSet.addWallType(s_wallType);
+
+    sf::Vector2i cell;
+    for (cell.y = 0; cell.y < rows; cell.y++)
+    for (cell.x = 0; cell.x < columns; cell.x++) {
+        bool wall = percent(random) < 20 || (cell.x % 24 == 12 && percent(random) < 90);
+        tileSet.setCellType(cell, wall ? s_wallType : s_floorType);
+    }
+
+    return tileSet;
+}
+
+// The cost of the path, throwing if it jumps, goes through a wall or cuts a wall's corner
+std::uint32_t checkPath(const TileSet& tileSet, const std::vector<sf::Vector2i>& path, const std::string& name) {
+    auto isOpen = [&](const sf::Vector2i& cell) { return tileSet.isOnTileSet(cell) && !tileSet.isSolid(cell); };
+
+    std::uint32_t cost = 0;
+
+    for (std::size_t i = 0; i < path.size(); i++) {
+        if (!isOpen(path[i]))
+            throw std::runtime_error(name + ": path goes through a wall at step " + std::to_string(i));
+
+        if (i == 0) continue;
+
+        sf::Vector2i step = path[i] - path[i - 1];
+        if (std::abs(step.x) > 1 || std::abs(step.y) > 1 || step == sf::Vector2i {})
+            throw std::runtime_error(name + ": path jumps at step " + std::to_string(i));
+
+        bool diagonal = step.x != 0 && step.y != 0;
+        if (diagonal && !(isOpen({ path[i].x, path[i - 1].y }) && isOpen({ path[i - 1].x, path[i].y })))
+            throw std::runtime_error(name + ": path cuts a corner at step " + std::to_string(i));
+
+        cost += diagonal ? 14 : 10;
+    }
+
+    return cost;
+}
+
+double timeSeconds(const std::function<void()>& run) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int queryCount = argc > 1 ? std::atoi(argv[1]) : 100;
+
+    // only the walls matter, so there's no need for a graphics context
+    TextureAtlas::get().setHeadless(true);
+
+    std::cout << "HierarchicalPathfinder against Dijkstra over every cell" << std::endl;
+
+    for (int size : { 128, 512 }) {
+        TileSet tileSet = generateMap(size, size);
+        HierarchicalPathfinder pathfinder;
+
+        double buildSeconds = timeSeconds([&]() { pathfinder.update(tileSet); });
+
+        std::mt19937 random(size);
+        std::uniform_int_distribution<int> coordinate(0, size - 1);
+
+        std::vector<std::pair<sf::Vector2i, sf::Vector2i>> queries;
+        while (static_cast<int>(queries.size()) < queryCount) {
+            sf::Vector2i start { coordinate(random), coordinate(random) };
+            sf::Vector2i goal { coordinate(random), coordinate(random) };
+            if (!tileSet.isSolid(start) && !tileSet.isSolid(goal)) queries.push_back({ start, goal });
+        }
+
+        std::vector<std::vector<sf::Vector2i>> paths;
+        double hierarchicalSeconds = timeSeconds([&]() {
+            for (auto& [start, goal] : queries) paths.push_back(pathfinder.findPath(tileSet, start, goal));
+        });
+
+        std::vector<std::uint32_t> costs;
+        double referenceSeconds = timeSeconds([&]() {
+            for (auto& [start, goal] : queries) costs.push_back(reference::findCost(tileSet, start, goal));
+        });
+
+        double totalRatio = 0.0;
+        double maxRatio = 1.0;
+        int found = 0;
+
+        for (std::size_t i = 0; i < queries.size(); i++) {
+            bool reachable = costs[i] != std::numeric_limits<std::uint32_t>::max();
+            if (paths[i].empty() != !reachable)
+                throw std::runtime_error("Query " + std::to_string(i) + " disagrees with Dijkstra on whether the goal is reachable");
+
+            if (!reachable || costs[i] == 0) continue;
+
+            double ratio = static_cast<double>(checkPath(tileSet, paths[i], "Query " + std::to_string(i))) / costs[i];
+            totalRatio += ratio;
+            maxRatio = std::max(maxRatio, ratio);
+            found++;
+        }
+
+        std::cout << "  " << size << "x" << size << ", " << pathfinder.getNodeCount() << " nodes: "
+                  << "build " << buildSeconds * 1000.0 << " ms, "
+                  << "hierarchical " << hierarchicalSeconds / queries.size() * 1000.0 << " ms, "
+                  << "Dijkstra " << referenceSeconds / queries.size() * 1000.0 << " ms per query, "
+                  << "cost ratio " << (found > 0 ? totalRatio / found : 1.0) << " average, " << maxRatio << " worst"
+                  << std::endl;
+    }
+
+    std::cout << "Stale graph checks" << std::endl;
+
+    TileSet tileSet = generateMap(128, 128);
+    sf::Vector2i start { 0, 0 };
+    sf::Vector2i goal { 127, 127 };
+    tileSet.setCellType(start, s_floorType);
+    tileSet.setCellType(goal, s_floorType);
+
+    // every edit lands on the path found before it, so a stale graph would walk through it
+    auto pathMiddle = [&](HierarchicalPathfinder& pathfinder) {
+        std::vector<sf::Vector2i> path = pathfinder.findPath(tileSet, start, goal);
+        if (path.size() < 3) throw std::runtime_error("Stale graph checks need a path between the corners");
+        return path[path.size() / 2];
+    };
+
+    // The path after an edit has to be valid and cost the same as one from a fresh graph
+    auto checkAfterEdit = [&](HierarchicalPathfinder& pathfinder, const std::string& name) {
+        std::vector<sf::Vector2i> path = pathfinder.findPath(tileSet, start, goal);
+        HierarchicalPathfinder fresh;
+        std::vector<sf::Vector2i> freshPath = fresh.findPath(tileSet, start, goal);
+
+        if (path.empty() != freshPath.empty() || checkPath(tileSet, path, name) != checkPath(tileSet, freshPath, name))
+            throw std::runtime_error(name + ": path differs from a freshly built graph's");
+
+        std::cout << "  " << name << ": ok" << std::endl;
+    };
+
+    {
+        HierarchicalPathfinder pathfinder;
+        for (int i = 0; i < 20; i++) {
+            sf::Vector2i cell = pathMiddle(pathfinder);
+            tileSet.setCellType(cell, s_wallType);
+            pathfinder.invalidateCell(cell);
+        }
+
+        checkAfterEdit(pathfinder, "invalidated walls");
+    }
+
+    {
+        HierarchicalPathfinder pathfinder;
+        // the cell on the path isn't a wall until its type becomes one, and an unrelated cell is
+        // invalidated, so only the wall type change says the graph is out of date
+        sf::Vector2i cell = pathMiddle(pathfinder);
+        tileSet.setCellType(cell, s_laterWallType);
+        pathfinder.invalidateCell({ 1, 0 });
+        tileSet.addWallType(s_laterWallType);
+
+        checkAfterEdit(pathfinder, "invalidated cell then a new wall type");
+    }
+
+    {
+        HierarchicalPathfinder pathfinder;
+        sf::Vector2i cell = pathMiddle(pathfinder);
+        tileSet.setCellType(cell, s_wallType);
+        // a cell that hasn't changed, so the count of invalidated cells can't cover the wall
+        pathfinder.invalidateCell({ 1, 0 });
+
+        checkAfterEdit(pathfinder, "wall added without invalidating it");
+    }
+
+    {
+        HierarchicalPathfinder pathfinder;
+        pathfinder.update(tileSet);
+        tileSet.addWallType(s_floorType + 100);
+
+        std::vector<HierarchicalPathfinder::RequestId> requests;
+        for (int i = 0; i < 10; i++) requests.push_back(pathfinder.requestPath(start, goal));
+
+        double seconds = timeSeconds([&]() { pathfinder.processRequests(tileSet, sf::microseconds(100)); });
+
+        std::cout << "  processRequests after a new wall type: " << seconds * 1000.0 << " ms with a 0.1 ms budget, "
+                  << 10 - pathfinder.getPendingRequestCount() << " of 10 answered" << std::endl;
+    }
+
+    return 0;
+}
@@ -4,15 +4,15 @@ Player::Resources Player::Resources::s_singleton {};
 
 Player::Player() :
     m_attackSpriteSheet(
-        Resources::get().attackSpriteSheetTexture(),
+        Resources::get().attackSpriteSheet(),
         1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } }
     ),
     m_walkSpriteSheet(
-        Resources::get().walkSpriteSheetTexture(),
+        Resources::get().walkSpriteSheet(),
         1, 4, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } }
     ),
     m_idleSpriteSheet(
-        Resources::get().idleSpriteSheetTexture(),
+        Resources::get().idleSpriteSheet(),
         1, 16, { { 0.f, 0.f }, { 1.f, 1.f / 4.f } }
     )
 {
@@ -41,29 +41,42 @@ SpriteSheet& Player::getCurrentSpriteSheet() {
 }
 
 sf::Vector2f Player::getFacingDirection() const {
-    static bool facingRight = true;
-    static bool facingForward = true;
-
-    facingRight   = (facingRight   || m_movement.x > s_movementThreshold) && m_movement.x >= -s_movementThreshold;
-    facingForward = (facingForward || m_movement.y > s_movementThreshold) && m_movement.y >= -s_movementThreshold;
-
     return {
-        facingRight ? 1.f : -1.f,
-        facingForward ? 1.f : -1.f
+        m_facingRight ? 1.f : -1.f,
+        m_facingForward ? 1.f : -1.f
     };
 }
 
-void Player::draw(sf::RenderTarget& target) {
+void Player::draw(sf::RenderTarget& target, float interpolation) {
     SpriteSheet& spriteSheet = getCurrentSpriteSheet();
-    spriteSheet.m_sprite.setPosition(m_position);
+    spriteSheet.m_sprite.setPosition(getInterpolatedPosition(interpolation));
     spriteSheet.draw(target);
 }
 
-void Player::movementUpdate(float deltaTime) {
-    bool leftPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Left);
-    bool rightPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Right);
-    bool upPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Up);
-    bool downPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Down);
+void Player::draw(DrawQueue& queue, float interpolation) {
+    sf::Vector2f position = getInterpolatedPosition(interpolation);
+
+    SpriteSheet& spriteSheet = getCurrentSpriteSheet();
+    spriteSheet.m_sprite.setPosition(position);
+    spriteSheet.draw(queue, e_CharacterLayer, position.y);
+}
+
+std::uint8_t Player::readKeyboard() {
+    std::uint8_t input = e_NoInput;
+
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Left)) input |= e_MoveLeft;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Right)) input |= e_MoveRight;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Up)) input |= e_MoveUp;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Down)) input |= e_MoveDown;
+
+    return input;
+}
+
+void Player::movementUpdate(float deltaTime, std::uint8_t input) {
+    bool leftPressed = input & e_MoveLeft;
+    bool rightPressed = input & e_MoveRight;
+    bool upPressed = input & e_MoveUp;
+    bool downPressed = input & e_MoveDown;
 
     m_movement.x += static_cast<float>(rightPressed - leftPressed) * deltaTime * 5.f;
     m_movement.y += static_cast<float>(downPressed - upPressed) * deltaTime * 5.f;
@@ -80,14 +93,16 @@ void Player::movementUpdate(float deltaTime) {
 }
 
 void Player::animationUpdate(float deltaTime) {
-    static bool hadFootDown = false;
-
     m_moving = std::sqrt(m_movement.x * m_movement.x + m_movement.y * m_movement.y) >= s_movementThreshold;
 
     m_footDown = m_moving && (m_walkSpriteSheet.getIndex() % 2 == 1);
 
-    if (m_footDown && !hadFootDown)
-        SoundManager::get().playSound(Resources::get().stepSound());
+    if (m_footDown && !m_hadFootDown)
+        SoundQueue::get().push(e_PlayerStepSound);
+
+    // keep facing the same way until moving clearly the other way
+    m_facingRight   = (m_facingRight   || m_movement.x > s_movementThreshold) && m_movement.x >= -s_movementThreshold;
+    m_facingForward = (m_facingForward || m_movement.y > s_movementThreshold) && m_movement.y >= -s_movementThreshold;
 
     // set the sprite sheets to use the correct animation for the facing direction
     sf::Vector2f facing = getFacingDirection();
@@ -107,33 +122,15 @@ void Player::animationUpdate(float deltaTime) {
     if (m_moving) m_idleSpriteSheet.setIndex(0);
     else          m_walkSpriteSheet.setIndex(0);
 
-    hadFootDown = m_footDown;
+    m_hadFootDown = m_footDown;
 }
 
-void Player::tileSetCollisionUpdate(TileSet& tileSet) {
-    sf::FloatRect playerBounds = getBounds();
-
-    sf::Vector2i offset, playerCell = tileSet.getCellAtPosition(m_position);
-    for (offset.y = -1; offset.y <= 1; offset.y++)
-    for (offset.x = -1; offset.x <= 1; offset.x++)
-    if (!(offset.x && offset.y)) {
-        sf::Vector2i cell = playerCell + offset;
-
-        sf::FloatRect tileBounds = tileSet.getCellBounds(cell);
-
-        if (tileSet.isWallType(tileSet.getCellType(cell)) && playerBounds.intersects(tileBounds)) {
-            sf::Vector2f tileCentre = tileBounds.getPosition() + tileBounds.getSize() * 0.5f;
-            sf::Vector2f deltaPosition = m_position - tileCentre;
+void Player::tileSetCollisionUpdate(const TileSet& tileSet) {
+    tileSet.resolveCollisions({ &m_position, 1 }, getBounds().getSize() * 0.5f);
+}
 
-            if (std::abs(deltaPosition.x) > std::abs(deltaPosition.y)) {
-                if (m_position.x < tileCentre.x) m_position.x = tileBounds.left - playerBounds.width * 0.5f;
-                else m_position.x = tileBounds.left + tileBounds.width + playerBounds.width * 0.5f;
-            } else {
-                if (m_position.y < tileCentre.y) m_position.y = tileBounds.top - playerBounds.height * 0.5f;
-                else m_position.y = tileBounds.top + tileBounds.height + playerBounds.height * 0.5f;
-            }
-        }
-    }
+void Player::tileSetCollisionUpdate(const PagedWorld& world) {
+    world.resolveCollisions({ &m_position, 1 }, getBounds().getSize() * 0.5f);
 }
 
 std::optional<sf::FloatRect> Player::getSwordBounds() const {
@@ -166,5 +163,69 @@ void Player::attack() {
 
     m_attacking = true;
     m_attackSpriteSheet.setIndex(0);
-    SoundManager::get().playSound(Resources::get().attackSound());
+    SoundQueue::get().push(e_PlayerAttackSound);
+}
+
+void Player::writeSnapshot(SnapshotWriter& writer) const {
+    writer.write(m_position);
+    writer.write(m_previousPosition);
+    writer.write(m_movement);
+
+    writer.write(m_moving);
+    writer.write(m_footDown);
+    writer.write(m_attacking);
+    writer.write(m_hadFootDown);
+    writer.write(m_facingRight);
+    writer.write(m_facingForward);
+
+    writer.write(m_attackSpriteSheet.getExactIndex());
+    writer.write(m_idleSpriteSheet.getExactIndex());
+    writer.write(m_walkSpriteSheet.getExactIndex());
+}
+
+// Flags are written as bools, a byte that isn't 0 or 1 would be undefined behaviour to read as one
+static bool readFlag(SnapshotReader& reader) {
+    std::uint8_t value = reader.read<std::uint8_t>();
+    if (value > 1)
+        throw std::runtime_error("Snapshot has a player flag that isn't 0 or 1");
+
+    return value != 0;
+}
+
+Player::Snapshot Player::readSnapshot(SnapshotReader& reader) {
+    Snapshot snapshot;
+
+    snapshot.m_position = reader.read<sf::Vector2f>();
+    snapshot.m_previousPosition = reader.read<sf::Vector2f>();
+    snapshot.m_movement = reader.read<sf::Vector2f>();
+
+    snapshot.m_moving = readFlag(reader);
+    snapshot.m_footDown = readFlag(reader);
+    snapshot.m_attacking = readFlag(reader);
+    snapshot.m_hadFootDown = readFlag(reader);
+    snapshot.m_facingRight = readFlag(reader);
+    snapshot.m_facingForward = readFlag(reader);
+
+    snapshot.m_attackIndex = reader.read<float>();
+    snapshot.m_idleIndex = reader.read<float>();
+    snapshot.m_walkIndex = reader.read<float>();
+
+    return snapshot;
+}
+
+void Player::restoreSnapshot(const Snapshot& snapshot) {
+    m_position = snapshot.m_position;
+    m_previousPosition = snapshot.m_previousPosition;
+    m_movement = snapshot.m_movement;
+
+    m_moving = snapshot.m_moving;
+    m_footDown = snapshot.m_footDown;
+    m_attacking = snapshot.m_attacking;
+    m_hadFootDown = snapshot.m_hadFootDown;
+    m_facingRight = snapshot.m_facingRight;
+    m_facingForward = snapshot.m_facingForward;
+
+    m_attackSpriteSheet.setIndex(snapshot.m_attackIndex);
+    m_idleSpriteSheet.setIndex(snapshot.m_idleIndex);
+    m_walkSpriteSheet.setIndex(snapshot.m_walkIndex);
 }
@@ -0,0 +1,218 @@
+#include <simulation.hpp>
+#include <mappedFile.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr char s_snapshotMagic[4] = { 'S', 'F', 'S', 'N' };
+constexpr std::uint32_t s_snapshotVersion = 2;
+
+struct SnapshotHeader {
+    char m_magic[4];
+    std::uint32_t m_version;
+    // Simulation::getLevelHash, a snapshot only restores onto a simulation of the same level
+    std::uint64_t m_levelHash;
+};
+
+constexpr std::uint64_t s_fnvOffsetBasis = 14695981039346656037ull;
+constexpr std::uint64_t s_fnvPrime = 1099511628211ull;
+
+template <typename T>
+void hashBytes(std::uint64_t& hash, std::span<const T> values) {
+    auto bytes = std::as_bytes(values);
+
+    for (std::byte byte : bytes) {
+        hash ^= static_cast<std::uint64_t>(byte);
+        hash *= s_fnvPrime;
+    }
+}
+
+}
+
+Simulation::Simulation(Level level) :
+    m_levelHash(hashLevel(level)),
+    m_map(
+        level.m_tileSetPath,
+        level.m_tileSetColumns,
+        level.m_tileSetRows,
+        level.m_mapScale,
+        std::move(level.m_layout)
+    )
+{
+    for (auto& spawn : level.m_spawns) {
+        switch (spawn.m_type) {
+        case e_Player:
+            m_player.m_position = spawn.m_position;
+            break;
+        case e_Orc:
+            m_orcs.add(spawn.m_position);
+            break;
+        default: break;
+        }
+    }
+
+    m_player.storePreviousPosition();
+    m_orcs.storePreviousPositions();
+
+    if (level.isPaged()) {
+        m_world = std::make_unique<PagedWorld>(
+            level.m_tileSetPath,
+            level.m_tileSetColumns,
+            level.m_tileSetRows,
+            level.m_mapScale,
+            level.m_mapFilePath,
+            s_worldMemoryBudget
+        );
+
+        // the layout isn't in the level, so the world's size stands in for it
+        int worldSize[3] { m_world->gridColumns(), m_world->gridRows(), m_world->regionSize() };
+        hashBytes(m_levelHash, std::span<const int>(worldSize));
+
+        m_world->setFocus(m_player.m_position);
+        m_world->update();
+    }
+}
+
+void Simulation::tick(std::uint8_t input) {
+    float deltaTime = s_tickLength;
+
+    m_player.storePreviousPosition();
+    m_orcs.storePreviousPositions();
+
+    if (m_world) {
+        m_world->setFocus(m_player.m_position);
+        m_world->update();
+    }
+
+    if (input & e_Attack) m_player.attack();
+
+    m_player.movementUpdate(deltaTime, input);
+    if (m_world) m_player.tileSetCollisionUpdate(*m_world);
+    else m_player.tileSetCollisionUpdate(m_map);
+    m_player.animationUpdate(deltaTime);
+
+    if (m_world) {
+        m_orcs.steerTowards(m_player.m_position, deltaTime);
+        m_orcs.tileSetCollisionUpdate(*m_world);
+    } else {
+        m_flowField.update(m_map, m_player.m_position);
+        m_orcs.steerTowards(m_player.m_position, deltaTime, &m_flowField);
+        m_orcs.tileSetCollisionUpdate(m_map);
+    }
+    m_orcs.updateAnimation(deltaTime);
+    m_orcs.attackUpdate();
+    m_orcs.takeSwordHits(m_player, 5.f);
+    m_orcs.removeDead();
+    m_orcs.preventIntersection(deltaTime);
+}
+
+std::uint64_t Simulation::hashLevel(const Level& level) {
+    std::uint64_t hash = s_fnvOffsetBasis;
+
+    hashBytes(hash, std::span(&level.m_tileSetColumns, 1));
+    hashBytes(hash, std::span(&level.m_tileSetRows, 1));
+    hashBytes(hash, std::span(&level.m_mapScale, 1));
+
+    hashBytes(hash, std::span(&level.m_layout.m_gridColumns, 1));
+    hashBytes(hash, std::span(&level.m_layout.m_gridRows, 1));
+    hashBytes(hash, std::span<const TileId>(level.m_layout.m_cells));
+    hashBytes(hash, std::span<const int>(level.m_layout.m_wallTypes));
+
+    for (auto& spawn : level.m_spawns) {
+        hashBytes(hash, std::span(&spawn.m_type, 1));
+        hashBytes(hash, std::span(&spawn.m_position, 1));
+    }
+
+    return hash;
+}
+
+std::uint64_t Simulation::getStateHash() const {
+    std::uint64_t hash = s_fnvOffsetBasis;
+
+    hashBytes(hash, std::span(&m_player.m_position, 1));
+    hashBytes(hash, std::span(&m_player.getMovement(), 1));
+
+    hashBytes(hash, std::span<const sf::Vector2f>(m_orcs.m_positions));
+    hashBytes(hash, std::span<const sf::Vector2f>(m_orcs.m_movements));
+    hashBytes(hash, m_orcs.getHealth());
+
+    return hash;
+}
+
+std::vector<char> Simulation::saveSnapshot() const {
+    std::vector<char> data;
+
+    // roughly the right size up front, so the buffer isn't regrown part way through the orcs
+    data.reserve(1024
+               + m_orcs.size() * (sizeof(sf::Vector2f) * 3 + sizeof(float) * (2 + e_OrcAnimationCount) + 1)
+               + static_cast<std::size_t>(m_map.gridColumns()) * m_map.gridRows() * sizeof(TileId));
+
+    SnapshotWriter writer { data };
+
+    SnapshotHeader header;
+    std::memcpy(header.m_magic, s_snapshotMagic, sizeof(s_snapshotMagic));
+    header.m_version = s_snapshotVersion;
+    header.m_levelHash = m_levelHash;
+    writer.write(header);
+
+    m_map.writeSnapshot(writer);
+    m_player.writeSnapshot(writer);
+    m_orcs.writeSnapshot(writer);
+
+    return data;
+}
+
+void Simulation::restoreSnapshot(std::span<const char> snapshot) {
+    SnapshotReader reader { snapshot };
+
+    SnapshotHeader header = reader.read<SnapshotHeader>();
+
+    if (std::memcmp(header.m_magic, s_snapshotMagic, sizeof(s_snapshotMagic)) != 0)
+        throw std::runtime_error("Not a snapshot");
+
+    if (header.m_version != s_snapshotVersion)
+        throw std::runtime_error(
+            "Snapshot is version " + std::to_string(header.m_version) +
+            ", expected " + std::to_string(s_snapshotVersion));
+
+    if (header.m_levelHash != m_levelHash)
+        throw std::runtime_error("Snapshot was saved on a different level");
+
+    // every section is read and checked before any is restored, so a bad snapshot changes nothing
+    TileSet::Snapshot map = m_map.readSnapshot(reader);
+    Player::Snapshot player = Player::readSnapshot(reader);
+    OrcStore::Snapshot orcs = OrcStore::readSnapshot(reader);
+
+    m_map.restoreSnapshot(map);
+    m_player.restoreSnapshot(player);
+    m_orcs.restoreSnapshot(std::move(orcs));
+}
+
+void Simulation::saveSnapshotToFile(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.good())
+        throw std::runtime_error("Could not write snapshot: " + filename);
+
+    std::vector<char> data = saveSnapshot();
+    file.write(data.data(), data.size());
+    // closed first, so a write that fails as the buffer is flushed is caught too
+    file.close();
+
+    if (!file.good())
+        throw std::runtime_error("Could not write snapshot: " + filename);
+}
+
+void Simulation::restoreSnapshotFromFile(const std::string& filename) {
+    MappedFile file(filename);
+
+    try {
+        restoreSnapshot({ file.data(), file.size() });
+    } catch (const std::runtime_error& error) {
+        throw std::runtime_error(std::string(error.what()) + ": " + filename);
+    }
+}
@@ -37,6 +37,18 @@ void SoundManager::playSound(sf::SoundBuffer& soundBuffer) {
     }
 }
 
+void SoundManager::loadSoundEffects() {
+    for (int sound = 0; sound < e_SoundEffectCount; sound++)
+        r_soundEffects[sound] = &loadSound(SoundQueue::getPath(static_cast<SoundEffect>(sound)));
+}
+
+void SoundManager::playQueuedSounds() {
+    SoundQueue::get().flush([this](SoundEffect sound) {
+        if (!r_soundEffects[sound]) r_soundEffects[sound] = &loadSound(SoundQueue::getPath(sound));
+        playSound(*r_soundEffects[sound]);
+    });
+}
+
 sf::Music& SoundManager::playMusic(const std::string& fileName) {
     // auto music = std::make_unique<sf::Music>();
     m_playingMusic.emplace_back();
@@ -0,0 +1,23 @@
+#include <soundQueue.hpp>
+
+namespace {
+
+constexpr const char* s_soundPaths[e_SoundEffectCount] = {
+    "../assets/audio/Minifantasy_Dungeon_SFX/07_human_atk_sword_1.wav",
+    "../assets/audio/Minifantasy_Dungeon_SFX/16_human_walk_stone_1.wav",
+    "../assets/audio/Minifantasy_Dungeon_SFX/17_orc_atk_sword_1.wav",
+    "../assets/audio/Minifantasy_Dungeon_SFX/25_orc_walk_stone_1.wav",
+    "../assets/audio/Minifantasy_Dungeon_SFX/21_orc_damage_3.wav",
+};
+
+}
+
+SoundQueue SoundQueue::s_singleton {};
+
+SoundQueue& SoundQueue::get() {
+    return s_singleton;
+}
+
+const char* SoundQueue::getPath(SoundEffect sound) {
+    return s_soundPaths[sound];
+}
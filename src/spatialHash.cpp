@@ -0,0 +1,41 @@
+#include <spatialHash.hpp>
+
+#include <algorithm>
+#include <bit>
+
+void SpatialHash::rebuild(std::span<const sf::Vector2f> positions) {
+    // about two buckets per point keeps collisions between cells rare
+    std::uint32_t tableSize = std::bit_ceil(std::max<std::uint32_t>(1, positions.size() * 2));
+    m_tableMask = tableSize - 1;
+
+    m_cells.resize(positions.size());
+    m_entries.resize(positions.size());
+    m_bucketStarts.assign(tableSize + 1, 0);
+
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        m_cells[i] = getCell(positions[i]);
+        m_bucketStarts[getBucket(m_cells[i]) + 1]++;
+    }
+
+    for (std::uint32_t bucket = 0; bucket < tableSize; bucket++)
+        m_bucketStarts[bucket + 1] += m_bucketStarts[bucket];
+
+    // fill each bucket in index order
+    m_nextEntries.assign(m_bucketStarts.begin(), m_bucketStarts.end() - 1);
+
+    for (std::size_t i = 0; i < positions.size(); i++)
+        m_entries[m_nextEntries[getBucket(m_cells[i])]++] = static_cast<std::uint32_t>(i);
+}
+
+std::span<const std::uint32_t> SpatialHash::getLaterNeighbours(std::uint32_t point) {
+    m_neighbours.clear();
+
+    forEachNear(point, [&](std::uint32_t other) {
+        if (other > point) m_neighbours.push_back(other);
+    });
+
+    std::sort(m_neighbours.begin(), m_neighbours.end());
+    m_neighbours.erase(std::unique(m_neighbours.begin(), m_neighbours.end()), m_neighbours.end());
+
+    return m_neighbours;
+}
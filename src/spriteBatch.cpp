@@ -0,0 +1,67 @@
+#include <spriteBatch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+void SpriteBatch::clear() {
+    m_vertices.clear();
+    m_runs.clear();
+}
+
+void SpriteBatch::clear(const sf::FloatRect& visibleArea) {
+    clear();
+    m_visibleArea = visibleArea;
+}
+
+void SpriteBatch::add(const sf::Sprite& sprite) {
+    add(sprite.getTexture(), sprite.getTextureRect(), sprite.getTransform(), sprite.getColor());
+}
+
+void SpriteBatch::add(const sf::Texture* texture, const sf::IntRect& textureRect, const sf::Transform& transform, sf::Color color) {
+    float width = static_cast<float>(std::abs(textureRect.width));
+    float height = static_cast<float>(std::abs(textureRect.height));
+
+    sf::Vector2f topLeft = transform.transformPoint({ 0.f, 0.f });
+    sf::Vector2f topRight = transform.transformPoint({ width, 0.f });
+    sf::Vector2f bottomLeft = transform.transformPoint({ 0.f, height });
+    sf::Vector2f bottomRight = transform.transformPoint({ width, height });
+
+    sf::Vector2f min {
+        std::min({ topLeft.x, topRight.x, bottomLeft.x, bottomRight.x }),
+        std::min({ topLeft.y, topRight.y, bottomLeft.y, bottomRight.y })
+    };
+
+    sf::Vector2f max {
+        std::max({ topLeft.x, topRight.x, bottomLeft.x, bottomRight.x }),
+        std::max({ topLeft.y, topRight.y, bottomLeft.y, bottomRight.y })
+    };
+
+    if (max.x < m_visibleArea.left || min.x > m_visibleArea.left + m_visibleArea.width ||
+        max.y < m_visibleArea.top  || min.y > m_visibleArea.top + m_visibleArea.height)
+        return;
+
+    if (m_runs.empty() || m_runs.back().r_texture != texture)
+        m_runs.push_back({ texture, m_vertices.size() });
+
+    // a negative width or height flips the sprite, just like sf::Sprite
+    float left = static_cast<float>(textureRect.left);
+    float right = left + static_cast<float>(textureRect.width);
+    float top = static_cast<float>(textureRect.top);
+    float bottom = top + static_cast<float>(textureRect.height);
+
+    m_vertices.push_back({ topLeft, color, { left, top } });
+    m_vertices.push_back({ topRight, color, { right, top } });
+    m_vertices.push_back({ bottomLeft, color, { left, bottom } });
+    m_vertices.push_back({ bottomLeft, color, { left, bottom } });
+    m_vertices.push_back({ topRight, color, { right, top } });
+    m_vertices.push_back({ bottomRight, color, { right, bottom } });
+}
+
+void SpriteBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    for (std::size_t i = 0; i < m_runs.size(); i++) {
+        std::size_t end = i + 1 < m_runs.size() ? m_runs[i + 1].m_firstVertex : m_vertices.size();
+
+        states.texture = m_runs[i].r_texture;
+        target.draw(&m_vertices[m_runs[i].m_firstVertex], end - m_runs[i].m_firstVertex, sf::PrimitiveType::Triangles, states);
+    }
+}
@@ -1,13 +1,34 @@
 #include <spriteSheet.hpp>
 
-SpriteSheet::SpriteSheet(sf::Texture& texture, int rows, int columns, sf::FloatRect region) :
-    m_rows(rows), m_columns(columns), m_index(0), m_animationRegion(region), r_texture(&texture)
+SpriteSheet::SpriteSheet(const TextureAtlas::Region& atlasRegion, int rows, int columns, sf::FloatRect region) :
+    r_texture(atlasRegion.r_texture), m_textureRect(atlasRegion.m_rect),
+    m_index(0), m_animationRegion(region), m_rows(rows), m_columns(columns)
 {
-    m_sprite.setTexture(getTexture());
+    // headless atlas regions have no texture, the sprite only needs one to be drawn
+    if (r_texture) m_sprite.setTexture(*r_texture);
 }
 
+SpriteSheet::SpriteSheet(const sf::Texture& texture, int rows, int columns, sf::FloatRect region) :
+    SpriteSheet(
+        TextureAtlas::Region { &texture, { { 0, 0 }, sf::Vector2i { texture.getSize() } } },
+        rows, columns, region
+    )
+{}
+
 bool SpriteSheet::hasFinished() const {
-    return !m_loop && getIndex() >= m_rows * m_columns;
+    return hasFinished(m_index);
+}
+
+bool SpriteSheet::hasFinished(float index) const {
+    return !m_loop && std::floor(index) >= m_rows * m_columns;
+}
+
+float SpriteSheet::getNextIndex(float index, float deltaTime) const {
+    float maxIndex = m_rows * m_columns;
+    index += deltaTime * m_animationSpeed;
+
+    return m_loop ? std::fmod(index, maxIndex)
+                  : std::min(index, maxIndex);
 }
 
 int SpriteSheet::getIndex() const {
@@ -33,8 +54,16 @@ void SpriteSheet::draw(sf::RenderTarget& target) {
     target.draw(m_sprite);
 }
 
+void SpriteSheet::draw(SpriteBatch& batch) {
+    batch.add(m_sprite);
+}
+
+void SpriteSheet::draw(DrawQueue& queue, std::uint32_t layer, float depth) {
+    queue.submit(layer, depth, m_sprite);
+}
+
 sf::Vector2f SpriteSheet::getTileSize() {
-    sf::Vector2u textureSize = getTexture().getSize();
+    sf::Vector2i textureSize = m_textureRect.getSize();
     return {
         textureSize.x * m_animationRegion.width / m_columns,
         textureSize.y * m_animationRegion.height / m_rows,
@@ -42,7 +71,7 @@ sf::Vector2f SpriteSheet::getTileSize() {
 }
 
 sf::IntRect SpriteSheet::getCurrentSpriteRect() {
-    sf::Vector2u textureSize = getTexture().getSize();
+    sf::Vector2i textureSize = m_textureRect.getSize();
 
     sf::Vector2i tileSize {
         static_cast<int>(m_animationRegion.width * textureSize.x / m_columns),
@@ -50,8 +79,8 @@ sf::IntRect SpriteSheet::getCurrentSpriteRect() {
     };
 
     sf::Vector2i offset {
-        static_cast<int>(m_animationRegion.left * textureSize.x),
-        static_cast<int>(m_animationRegion.top * textureSize.y),
+        m_textureRect.left + static_cast<int>(m_animationRegion.left * textureSize.x),
+        m_textureRect.top + static_cast<int>(m_animationRegion.top * textureSize.y),
     };
 
     int index = hasFinished() ? getIndex() - 1 : getIndex();
@@ -0,0 +1,254 @@
+#include <steeringKernel.hpp>
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define STEERING_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+#if defined(STEERING_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define STEERING_KERNEL_AVX2
+#define STEERING_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+using Parameters = SteeringKernel::Parameters;
+
+void steerTowardsScalar(sf::Vector2f* positions, sf::Vector2f* movements, std::uint8_t* flags, const sf::Vector2f* directions, std::size_t begin, std::size_t count, const Parameters& parameters) {
+    for (std::size_t i = begin; i < count; i++) {
+        sf::Vector2f diff = parameters.m_target - positions[i];
+
+        float length = std::sqrt(
+            diff.x * diff.x +
+            diff.y * diff.y);
+
+        if (length > parameters.m_arrivalDistance) {
+            movements[i] = directions ? directions[i] : diff / length;
+            flags[i] &= ~parameters.m_arrivedFlag;
+        } else {
+            movements[i] *= parameters.m_arrivedDamping;
+            flags[i] |= parameters.m_arrivedFlag;
+        }
+
+        if (!(flags[i] & parameters.m_frozenFlags))
+            positions[i] += movements[i] * parameters.m_speed * parameters.m_deltaTime;
+    }
+}
+
+// The lanes hold the x or y of entities 0, 1, 2, 3 for SSE2 and 0, 1, 4, 5, 2, 3, 6, 7 for AVX2,
+// the order they come out of deinterleaving pairs of vectors, so flags are gathered to match
+// and the arrived mask is scattered back the same way.
+
+#ifdef STEERING_KERNEL_X86
+
+void steerTowardsSSE2(sf::Vector2f* positions, sf::Vector2f* movements, std::uint8_t* flags, const sf::Vector2f* directions, std::size_t count, const Parameters& parameters) {
+    float* position = reinterpret_cast<float*>(positions);
+    float* movement = reinterpret_cast<float*>(movements);
+    const float* direction = reinterpret_cast<const float*>(directions);
+
+    const __m128 targetX = _mm_set1_ps(parameters.m_target.x);
+    const __m128 targetY = _mm_set1_ps(parameters.m_target.y);
+    const __m128 arrivalDistance = _mm_set1_ps(parameters.m_arrivalDistance);
+    const __m128 damping = _mm_set1_ps(parameters.m_arrivedDamping);
+    const __m128 speed = _mm_set1_ps(parameters.m_speed);
+    const __m128 deltaTime = _mm_set1_ps(parameters.m_deltaTime);
+    const __m128i frozenFlags = _mm_set1_epi32(parameters.m_frozenFlags);
+
+    std::size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 positions0 = _mm_loadu_ps(position + i * 2);
+        __m128 positions1 = _mm_loadu_ps(position + i * 2 + 4);
+        __m128 x = _mm_shuffle_ps(positions0, positions1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(positions0, positions1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 movements0 = _mm_loadu_ps(movement + i * 2);
+        __m128 movements1 = _mm_loadu_ps(movement + i * 2 + 4);
+        __m128 movementX = _mm_shuffle_ps(movements0, movements1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 movementY = _mm_shuffle_ps(movements0, movements1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 diffX = _mm_sub_ps(targetX, x);
+        __m128 diffY = _mm_sub_ps(targetY, y);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)));
+
+        __m128 far = _mm_cmpgt_ps(length, arrivalDistance);
+
+        __m128 directionX, directionY;
+
+        if (direction) {
+            __m128 directions0 = _mm_loadu_ps(direction + i * 2);
+            __m128 directions1 = _mm_loadu_ps(direction + i * 2 + 4);
+            directionX = _mm_shuffle_ps(directions0, directions1, _MM_SHUFFLE(2, 0, 2, 0));
+            directionY = _mm_shuffle_ps(directions0, directions1, _MM_SHUFFLE(3, 1, 3, 1));
+        } else {
+            directionX = _mm_div_ps(diffX, length);
+            directionY = _mm_div_ps(diffY, length);
+        }
+
+        movementX = _mm_or_ps(_mm_and_ps(far, directionX), _mm_andnot_ps(far, _mm_mul_ps(movementX, damping)));
+        movementY = _mm_or_ps(_mm_and_ps(far, directionY), _mm_andnot_ps(far, _mm_mul_ps(movementY, damping)));
+
+        int farMask = _mm_movemask_ps(far);
+        for (int lane = 0; lane < 4; lane++) {
+            if (farMask >> lane & 1) flags[i + lane] &= ~parameters.m_arrivedFlag;
+            else                     flags[i + lane] |= parameters.m_arrivedFlag;
+        }
+
+        __m128i laneFlags = _mm_setr_epi32(flags[i], flags[i + 1], flags[i + 2], flags[i + 3]);
+        __m128 moving = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(laneFlags, frozenFlags), _mm_setzero_si128()));
+
+        x = _mm_add_ps(x, _mm_and_ps(moving, _mm_mul_ps(_mm_mul_ps(movementX, speed), deltaTime)));
+        y = _mm_add_ps(y, _mm_and_ps(moving, _mm_mul_ps(_mm_mul_ps(movementY, speed), deltaTime)));
+
+        _mm_storeu_ps(position + i * 2, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(position + i * 2 + 4, _mm_unpackhi_ps(x, y));
+        _mm_storeu_ps(movement + i * 2, _mm_unpacklo_ps(movementX, movementY));
+        _mm_storeu_ps(movement + i * 2 + 4, _mm_unpackhi_ps(movementX, movementY));
+    }
+
+    steerTowardsScalar(positions, movements, flags, directions, i, count, parameters);
+}
+
+#endif
+
+#ifdef STEERING_KERNEL_AVX2
+
+STEERING_KERNEL_TARGET_AVX2
+void steerTowardsAVX2(sf::Vector2f* positions, sf::Vector2f* movements, std::uint8_t* flags, const sf::Vector2f* directions, std::size_t count, const Parameters& parameters) {
+    float* position = reinterpret_cast<float*>(positions);
+    float* movement = reinterpret_cast<float*>(movements);
+    const float* direction = reinterpret_cast<const float*>(directions);
+
+    const __m256 targetX = _mm256_set1_ps(parameters.m_target.x);
+    const __m256 targetY = _mm256_set1_ps(parameters.m_target.y);
+    const __m256 arrivalDistance = _mm256_set1_ps(parameters.m_arrivalDistance);
+    const __m256 damping = _mm256_set1_ps(parameters.m_arrivedDamping);
+    const __m256 speed = _mm256_set1_ps(parameters.m_speed);
+    const __m256 deltaTime = _mm256_set1_ps(parameters.m_deltaTime);
+    const __m256i frozenFlags = _mm256_set1_epi32(parameters.m_frozenFlags);
+
+    static constexpr int laneEntities[8] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 positions0 = _mm256_loadu_ps(position + i * 2);
+        __m256 positions1 = _mm256_loadu_ps(position + i * 2 + 8);
+        __m256 x = _mm256_shuffle_ps(positions0, positions1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 y = _mm256_shuffle_ps(positions0, positions1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m256 movements0 = _mm256_loadu_ps(movement + i * 2);
+        __m256 movements1 = _mm256_loadu_ps(movement + i * 2 + 8);
+        __m256 movementX = _mm256_shuffle_ps(movements0, movements1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 movementY = _mm256_shuffle_ps(movements0, movements1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m256 diffX = _mm256_sub_ps(targetX, x);
+        __m256 diffY = _mm256_sub_ps(targetY, y);
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(diffX, diffX), _mm256_mul_ps(diffY, diffY)));
+
+        __m256 far = _mm256_cmp_ps(length, arrivalDistance, _CMP_GT_OQ);
+
+        __m256 directionX, directionY;
+
+        if (direction) {
+            __m256 directions0 = _mm256_loadu_ps(direction + i * 2);
+            __m256 directions1 = _mm256_loadu_ps(direction + i * 2 + 8);
+            directionX = _mm256_shuffle_ps(directions0, directions1, _MM_SHUFFLE(2, 0, 2, 0));
+            directionY = _mm256_shuffle_ps(directions0, directions1, _MM_SHUFFLE(3, 1, 3, 1));
+        } else {
+            directionX = _mm256_div_ps(diffX, length);
+            directionY = _mm256_div_ps(diffY, length);
+        }
+
+        movementX = _mm256_blendv_ps(_mm256_mul_ps(movementX, damping), directionX, far);
+        movementY = _mm256_blendv_ps(_mm256_mul_ps(movementY, damping), directionY, far);
+
+        int farMask = _mm256_movemask_ps(far);
+        for (int lane = 0; lane < 8; lane++) {
+            std::uint8_t& entityFlags = flags[i + laneEntities[lane]];
+            if (farMask >> lane & 1) entityFlags &= ~parameters.m_arrivedFlag;
+            else                     entityFlags |= parameters.m_arrivedFlag;
+        }
+
+        __m256i laneFlags = _mm256_setr_epi32(
+            flags[i],     flags[i + 1], flags[i + 4], flags[i + 5],
+            flags[i + 2], flags[i + 3], flags[i + 6], flags[i + 7]);
+        __m256 moving = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(laneFlags, frozenFlags), _mm256_setzero_si256()));
+
+        x = _mm256_add_ps(x, _mm256_and_ps(moving, _mm256_mul_ps(_mm256_mul_ps(movementX, speed), deltaTime)));
+        y = _mm256_add_ps(y, _mm256_and_ps(moving, _mm256_mul_ps(_mm256_mul_ps(movementY, speed), deltaTime)));
+
+        _mm256_storeu_ps(position + i * 2, _mm256_unpacklo_ps(x, y));
+        _mm256_storeu_ps(position + i * 2 + 8, _mm256_unpackhi_ps(x, y));
+        _mm256_storeu_ps(movement + i * 2, _mm256_unpacklo_ps(movementX, movementY));
+        _mm256_storeu_ps(movement + i * 2 + 8, _mm256_unpackhi_ps(movementX, movementY));
+    }
+
+    steerTowardsScalar(positions, movements, flags, directions, i, count, parameters);
+}
+
+#endif
+
+SteeringKernel::Implementation detectBestImplementation() {
+#ifdef STEERING_KERNEL_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SteeringKernel::Implementation::AVX2;
+#endif
+
+#ifdef STEERING_KERNEL_X86
+    return SteeringKernel::Implementation::SSE2;
+#else
+    return SteeringKernel::Implementation::Scalar;
+#endif
+}
+
+}
+
+bool SteeringKernel::isSupported(Implementation implementation) {
+    static const Implementation best = detectBestImplementation();
+
+    switch (implementation) {
+    case Implementation::Scalar : return true;
+    case Implementation::SSE2   : return best == Implementation::SSE2 || best == Implementation::AVX2;
+    case Implementation::AVX2   : return best == Implementation::AVX2;
+    case Implementation::Best   : return true;
+    default                     : return false;
+    }
+}
+
+const char* SteeringKernel::getName(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::Scalar : return "scalar";
+    case Implementation::SSE2   : return "SSE2";
+    case Implementation::AVX2   : return "AVX2";
+    case Implementation::Best   : return "best";
+    default                     : return "unknown";
+    }
+}
+
+void SteeringKernel::steerTowards(
+    sf::Vector2f* positions,
+    sf::Vector2f* movements,
+    std::uint8_t* flags,
+    std::size_t count,
+    const Parameters& parameters,
+    const sf::Vector2f* directions,
+    Implementation implementation
+) {
+    static const Implementation best = detectBestImplementation();
+
+    if (implementation == Implementation::Best || !isSupported(implementation))
+        implementation = best;
+
+    switch (implementation) {
+#ifdef STEERING_KERNEL_AVX2
+    case Implementation::AVX2: return steerTowardsAVX2(positions, movements, flags, directions, count, parameters);
+#endif
+#ifdef STEERING_KERNEL_X86
+    case Implementation::SSE2: return steerTowardsSSE2(positions, movements, flags, directions, count, parameters);
+#endif
+    default: return steerTowardsScalar(positions, movements, flags, directions, 0, count, parameters);
+    }
+}
@@ -0,0 +1,192 @@
+#include <textureAtlas.hpp>
+#include <csvParser.hpp>
+
+#include <filesystem>
+#include <iterator>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+TextureAtlas TextureAtlas::s_singleton {};
+
+TextureAtlas& TextureAtlas::get() {
+    return s_singleton;
+}
+
+void TextureAtlas::setHeadless(bool headless) {
+    if (!m_pages.empty())
+        throw std::runtime_error("Texture atlas mode can't change once images are loaded");
+
+    m_headless = headless;
+}
+
+TextureAtlas::Page& TextureAtlas::addPage() {
+    // querying the maximum texture size needs a graphics context
+    if (m_pageSize == 0)
+        m_pageSize = m_headless ? s_maxPageSize : std::min(s_maxPageSize, sf::Texture::getMaximumSize());
+
+    Page& page = m_pages.emplace_back();
+
+    if (m_headless) {
+        page.m_image.create(m_pageSize, m_pageSize, sf::Color::Transparent);
+        return page;
+    }
+
+    if (!page.m_texture.emplace().create(m_pageSize, m_pageSize))
+        throw std::runtime_error("Failed to create texture atlas page " + std::to_string(m_pages.size()));
+
+    // a new texture's pixels are undefined, and the padding between images has to be clear
+    sf::Image clear;
+    clear.create(m_pageSize, m_pageSize, sf::Color::Transparent);
+    page.m_texture->update(clear, 0, 0);
+
+    return page;
+}
+
+bool TextureAtlas::tryPack(Page& page, sf::Vector2u size, sf::Vector2u& position) {
+    sf::Vector2u paddedSize { size.x + s_padding, size.y + s_padding };
+
+    // the first shelf that's tall enough and has room left
+    for (auto& shelf : page.m_shelves) {
+        if (paddedSize.y > shelf.m_height || shelf.m_nextLeft + paddedSize.x > m_pageSize) continue;
+
+        position = { shelf.m_nextLeft, shelf.m_top };
+        shelf.m_nextLeft += paddedSize.x;
+        return true;
+    }
+
+    if (page.m_nextShelfTop + paddedSize.y > m_pageSize || paddedSize.x > m_pageSize)
+        return false;
+
+    page.m_shelves.push_back({ page.m_nextShelfTop, paddedSize.y, paddedSize.x });
+    position = { 0, page.m_nextShelfTop };
+    page.m_nextShelfTop += paddedSize.y;
+
+    return true;
+}
+
+const TextureAtlas::Region& TextureAtlas::addImage(const std::string& name, const sf::Image& image) {
+    sf::Vector2u size = image.getSize();
+    sf::Vector2u position;
+
+    auto page = m_pages.begin();
+    while (page != m_pages.end() && !tryPack(*page, size, position)) page++;
+
+    if (page == m_pages.end()) {
+        addPage();
+        page = std::prev(m_pages.end());
+
+        if (!tryPack(*page, size, position))
+            throw std::runtime_error("Image is too big for a texture atlas page: " + name);
+    }
+
+    if (m_headless) page->m_image.copy(image, position.x, position.y);
+    else page->m_texture->update(image, position.x, position.y);
+
+    Region region {
+        page->m_texture ? &*page->m_texture : nullptr,
+        { { static_cast<int>(position.x), static_cast<int>(position.y) },
+          { static_cast<int>(size.x), static_cast<int>(size.y) } },
+        static_cast<std::size_t>(std::distance(m_pages.begin(), page))
+    };
+
+    return m_regions.emplace(name, region).first->second;
+}
+
+const TextureAtlas::Region& TextureAtlas::load(const std::string& filename) {
+    auto it = m_regions.find(filename);
+    if (it != m_regions.end()) return it->second;
+
+    sf::Image image;
+    if (!image.loadFromFile(filename))
+        throw std::runtime_error("Failed to load texture from file: " + filename);
+
+    return addImage(filename, image);
+}
+
+void TextureAtlas::loadManifest(const std::string& manifestFilename) {
+    std::ifstream manifest(manifestFilename);
+    if (!manifest.good())
+        throw std::runtime_error("Could not open texture atlas manifest: " + manifestFilename);
+
+    std::filesystem::path directory = std::filesystem::path(manifestFilename).parent_path();
+    std::vector<Page*> pages;
+
+    CSVParser::forEachRow(manifest, [&](unsigned int row, std::span<const std::string_view> cells) {
+        // the first row is the page images
+        if (row == 0) {
+            for (auto cell : cells) {
+                Page& page = m_pages.emplace_back();
+                std::string pageFilename = (directory / cell).string();
+
+                sf::Image image;
+                if (!image.loadFromFile(pageFilename))
+                    throw std::runtime_error("Failed to load texture atlas page: " + pageFilename);
+
+                if (m_headless) page.m_image = std::move(image);
+                else if (!page.m_texture.emplace().loadFromImage(image))
+                    throw std::runtime_error("Failed to create texture atlas page: " + pageFilename);
+
+                // nothing else is packed onto a page built offline
+                page.m_nextShelfTop = std::numeric_limits<unsigned int>::max() / 2;
+                pages.push_back(&page);
+            }
+
+            return;
+        }
+
+        if (cells.size() < 6)
+            throw std::runtime_error("Texture atlas manifest row " + std::to_string(row) + " should have six cells: " + manifestFilename);
+
+        std::size_t pageIndex = CSVParser::parseCell<std::size_t>(cells[1]);
+        if (pageIndex >= pages.size())
+            throw std::runtime_error("Texture atlas manifest row " + std::to_string(row) + " has no page: " + manifestFilename);
+
+        Page& page = *pages[pageIndex];
+
+        // pages listed by this manifest come after any already loaded
+        Region region {
+            page.m_texture ? &*page.m_texture : nullptr,
+            { { CSVParser::parseCell<int>(cells[2]), CSVParser::parseCell<int>(cells[3]) },
+              { CSVParser::parseCell<int>(cells[4]), CSVParser::parseCell<int>(cells[5]) } },
+            m_pages.size() - pages.size() + pageIndex
+        };
+
+        m_regions.insert_or_assign(std::string(cells[0]), region);
+    });
+}
+
+void TextureAtlas::saveToFiles(const std::string& manifestFilename) const {
+    std::filesystem::path manifestPath { manifestFilename };
+    std::vector<std::string> pageFilenames;
+
+    for (std::size_t i = 0; i < m_pages.size(); i++)
+        pageFilenames.push_back(manifestPath.stem().string() + std::to_string(i) + ".png");
+
+    std::ofstream manifest(manifestFilename, std::ios::trunc);
+    if (!manifest.good())
+        throw std::runtime_error("Could not write texture atlas manifest: " + manifestFilename);
+
+    std::size_t pageIndex = 0;
+    for (auto& page : m_pages) {
+        std::string pageFilename = (manifestPath.parent_path() / pageFilenames[pageIndex]).string();
+
+        bool saved = m_headless ? page.m_image.saveToFile(pageFilename)
+                                : page.m_texture->copyToImage().saveToFile(pageFilename);
+
+        if (!saved)
+            throw std::runtime_error("Failed to write texture atlas page: " + pageFilename);
+
+        manifest << pageFilenames[pageIndex] << (pageIndex + 1 < m_pages.size() ? ',' : '\n');
+        pageIndex++;
+    }
+
+    for (auto& [name, region] : m_regions) {
+        manifest << name << ','
+                 << region.m_page << ','
+                 << region.m_rect.left << ','
+                 << region.m_rect.top << ','
+                 << region.m_rect.width << ','
+                 << region.m_rect.height << '\n';
+    }
+}
@@ -0,0 +1,164 @@
+#include <tileLayout.hpp>
+#include <csvParser.hpp>
+#include <jobSystem.hpp>
+#include <mappedFile.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Below this handing a chunk to another thread costs more than parsing it
+constexpr std::size_t s_minimumChunkSize = 1 << 20;
+
+struct LayoutChunk {
+    std::string_view m_text;
+    std::size_t m_firstRow = 0;
+    std::size_t m_rowCount = 0;
+    std::exception_ptr m_error;
+};
+
+std::size_t countLines(std::string_view text) {
+    std::size_t lines = std::count(text.begin(), text.end(), '\n');
+
+    // the end of the text finishes a line without a newline, just like CSVParser::splitLines
+    if (!text.empty() && text.back() != '\n') lines++;
+
+    return lines;
+}
+
+// Splits text into roughly equal chunks that each end just after a newline
+std::vector<LayoutChunk> splitIntoChunks(std::string_view text, unsigned int chunkCount) {
+    std::vector<LayoutChunk> chunks;
+    std::size_t chunkStart = 0;
+
+    for (unsigned int i = 1; i <= chunkCount && chunkStart < text.size(); i++) {
+        std::size_t chunkEnd = text.size() * i / chunkCount;
+
+        if (chunkEnd < chunkStart) chunkEnd = chunkStart;
+        if (chunkEnd < text.size()) chunkEnd = std::min(text.find('\n', chunkEnd), text.size() - 1) + 1;
+
+        chunks.push_back({ text.substr(chunkStart, chunkEnd - chunkStart), 0, 0, nullptr });
+        chunkStart = chunkEnd;
+    }
+
+    return chunks;
+}
+
+// Runs task(i) for every chunk on the job system, then rethrows the exception from the earliest
+// chunk that threw, so errors are reported the same however the chunks were scheduled
+template <typename Task>
+void runInParallel(std::vector<LayoutChunk>& chunks, Task&& task) {
+    JobSystem::get().parallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            try { task(i); }
+            catch (...) { chunks[i].m_error = std::current_exception(); }
+        }
+    });
+
+    for (auto& chunk : chunks)
+        if (chunk.m_error) std::rethrow_exception(chunk.m_error);
+}
+
+}
+
+TileLayout TileLayout::loadFromFile(const std::string& layoutFilename, unsigned int threadCount) {
+    MappedFile file;
+
+    try {
+        file = MappedFile(layoutFilename);
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("Failed to open tileset layout: " + layoutFilename);
+    }
+
+    TileLayout layout;
+
+    std::string_view text = file.view();
+    std::string_view wallTypes = text.substr(0, text.find('\n'));
+    std::string_view grid = text.substr(std::min(wallTypes.size() + 1, text.size()));
+
+    CSVParser::splitLines(wallTypes, [&](std::size_t begin, std::size_t end) {
+        layout.m_wallTypes.push_back(CSVParser::parseCell<int>(wallTypes.substr(begin, end - begin)));
+    }, []() {});
+
+    // every row has to match the first one
+    std::string_view firstRow = grid.substr(0, grid.find('\n'));
+    CSVParser::splitLines(firstRow, [&](std::size_t begin, std::size_t end) {
+        TileId tile;
+        std::size_t count;
+        layout.m_gridColumns += parseRun(firstRow.substr(begin, end - begin), tile, count) ? count : 1;
+    }, []() {});
+
+    if (threadCount == 0) threadCount = JobSystem::getThreadCount();
+    threadCount = std::min<std::size_t>(threadCount, grid.size() / s_minimumChunkSize + 1);
+
+    std::vector<LayoutChunk> chunks = splitIntoChunks(grid, threadCount);
+
+    // count each chunk's rows first, so each one knows where its slice of m_cells starts
+    runInParallel(chunks, [&](std::size_t i) {
+        chunks[i].m_rowCount = countLines(chunks[i].m_text);
+    });
+
+    for (std::size_t i = 1; i < chunks.size(); i++)
+        chunks[i].m_firstRow = chunks[i - 1].m_firstRow + chunks[i - 1].m_rowCount;
+
+    layout.m_gridRows = chunks.empty() ? 0 : chunks.back().m_firstRow + chunks.back().m_rowCount;
+    layout.m_cells.resize(static_cast<std::size_t>(layout.m_gridRows) * layout.m_gridColumns);
+
+    auto parseChunk = [&](std::size_t i) {
+        const LayoutChunk& chunk = chunks[i];
+
+        std::size_t row = chunk.m_firstRow;
+        std::size_t column = 0;
+        std::size_t gridColumns = static_cast<std::size_t>(layout.m_gridColumns);
+        TileId* rowCells = layout.m_cells.data() + row * layout.m_gridColumns;
+
+        // rows are numbered from the wall type row in error messages, as they are in the file
+        auto rowError = [&](const std::string& message) {
+            return std::runtime_error("Layout row " + std::to_string(row + 1) + " " + message + ": " + layoutFilename);
+        };
+
+        CSVParser::splitLines(chunk.m_text, [&](std::size_t begin, std::size_t end) {
+            TileId tile;
+            std::size_t count;
+
+            if (!parseRun(chunk.m_text.substr(begin, end - begin), tile, count))
+                throw rowError("cell " + std::to_string(column) + " is not a tile index");
+
+            if (column + count > gridColumns)
+                throw rowError("has more than " + std::to_string(layout.m_gridColumns) + " cells");
+
+            std::fill_n(rowCells + column, count, tile);
+            column += count;
+        }, [&]() {
+            if (column != gridColumns)
+                throw rowError("has " + std::to_string(column) + " cells, expected " + std::to_string(layout.m_gridColumns));
+
+            row++;
+            column = 0;
+            rowCells += layout.m_gridColumns;
+        });
+    };
+
+    runInParallel(chunks, parseChunk);
+
+    return layout;
+}
+
+bool TileLayout::parseRun(std::string_view cell, TileId& tile, std::size_t& count) {
+    std::size_t star = cell.find('*');
+
+    std::errc error;
+    tile = CSVParser::parseCell<TileId>(cell.substr(0, star), error);
+    if (error != std::errc {}) return false;
+
+    if (star == std::string_view::npos) {
+        count = 1;
+        return true;
+    }
+
+    count = CSVParser::parseCell<std::size_t>(cell.substr(star + 1), error);
+    return error == std::errc {} && count > 0;
+}
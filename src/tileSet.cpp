@@ -1,8 +1,11 @@
 #include <tileSet.hpp>
-#include <csvParser.hpp>
+#include <tileCollision.hpp>
+#include <viewBounds.hpp>
 #include <fstream>
 #include <string>
-#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 TileSet::TileSet(
     const std::string& textureFilename,
@@ -11,34 +14,29 @@ TileSet::TileSet(
     float scale,
     const std::string& layoutFilename
 )   :
+    TileSet(textureFilename, tileSetColumns, tileSetRows, scale, TileLayout::loadFromFile(layoutFilename))
+{}
+
+TileSet::TileSet(
+    const std::string& textureFilename,
+    int tileSetColumns,
+    int tileSetRows,
+    float scale,
+    TileLayout layout
+)   :
+    m_cells(std::move(layout.m_cells)),
     m_tileSetRows(tileSetRows),
     m_tileSetColumns(tileSetColumns),
+    m_gridRows(layout.m_gridRows),
+    m_gridColumns(layout.m_gridColumns),
     m_scale(scale)
 {
-    if (!m_texture.loadFromFile(textureFilename))
-        throw std::runtime_error("Failed to open tileset texture: " + textureFilename);
-
-    std::ifstream layoutFile(layoutFilename);
-
-    std::string firstLine;
-    std::getline(layoutFile, firstLine);
-    std::stringstream firstLineStream(firstLine);
+    m_atlasRegion = TextureAtlas::get().load(textureFilename);
 
-    CSVParser wallTypes(firstLineStream, false);
-    for (const auto& type : wallTypes.getRow(0))
-        addWallType(std::atoi(type.c_str()));
-
-    CSVParser layout(layoutFile, false);
-    
-    m_gridColumns = layout.getColumnCount();
-    m_gridRows = layout.getRowCount();
+    updateCellSize();
+    addWallTypes(layout.m_wallTypes);
 
-    m_cells.resize(m_gridRows * m_gridColumns);
-    for (int j = 0; j < m_gridRows; j++)
-    for (int i = 0; i < m_gridColumns; i++)
-        m_cells[i + j * m_gridColumns] = std::atoi(layout.getCell(j, i).c_str());
-    
-    updateVertices();
+    rebuildVertices();
 }
 
 TileSet::TileSet(
@@ -49,20 +47,21 @@ TileSet::TileSet(
     int gridColumns,
     int gridRows
 )   :
+    m_cells(gridRows * gridColumns, 0),
     m_tileSetRows(tileSetRows),
     m_tileSetColumns(tileSetColumns),
-    m_scale(scale),
-    m_gridColumns(gridColumns),
     m_gridRows(gridRows),
-    m_cells(gridRows * gridColumns, 0)
+    m_gridColumns(gridColumns),
+    m_scale(scale)
 {
-    if (!m_texture.loadFromFile(textureFilename))
-        throw std::runtime_error("Failed to open tileset texture: " + textureFilename);
-    
-    updateVertices();
+    m_atlasRegion = TextureAtlas::get().load(textureFilename);
+
+    updateCellSize();
+    rebuildSolidity();
+    rebuildVertices();
 }
 
-void TileSet::saveToFile(const std::string& layoutFilename) {
+void TileSet::saveToFile(const std::string& layoutFilename, bool compact) {
     std::ofstream file(layoutFilename);
 
     for (const auto& wallType : m_wallTypes)
@@ -70,113 +69,203 @@ void TileSet::saveToFile(const std::string& layoutFilename) {
     file << std::endl;
 
     for (int row = 0; row < m_gridRows; row++)
-    for (int column = 0; column < m_gridColumns; column++) {
-        file << getCellType({ column, row });
+    for (int column = 0; column < m_gridColumns;) {
+        TileId tile = m_cells[column + row * m_gridColumns];
+        int runLength = 1;
+
+        if (compact)
+            while (column + runLength < m_gridColumns && m_cells[column + runLength + row * m_gridColumns] == tile)
+                runLength++;
+
+        file << tile;
+        if (runLength > 1) file << '*' << runLength;
+
+        column += runLength;
 
-        if (column + 1 < m_gridColumns) file << ',';
+        if (column < m_gridColumns) file << ',';
         else file << '\n';
     }
 }
 
 void TileSet::updateVertices() {
-    m_vertices.resize(6 * m_gridRows * m_gridColumns);
-    m_vertices.setPrimitiveType(sf::PrimitiveType::Triangles);
+    for (int chunk : m_dirtyChunks)
+        rebuildChunkVertices(chunk % m_chunkColumns, chunk / m_chunkColumns);
 
-    sf::Vector2u textureSize = m_texture.getSize();
-    sf::Vector2f tileSize {
-        textureSize.x / static_cast<float>(m_tileSetColumns),
-        textureSize.y / static_cast<float>(m_tileSetRows)
-    };
+    m_dirtyChunks.clear();
+}
 
-    sf::Vector2f gridSize = tileSize * m_scale;
-
-    for (int j = 0; j < m_gridRows; j++)
-    for (int i = 0; i < m_gridColumns; i++) {
-        int tileIndex = m_cells[i + j * m_gridColumns];
-
-        int tileColumn = tileIndex % m_tileSetColumns;
-        int tileRow = tileIndex / m_tileSetColumns;
-
-        sf::FloatRect tile { { tileColumn * tileSize.x, tileRow * tileSize.y }, tileSize };
-        sf::FloatRect cell { { i * gridSize.x, j * gridSize.y }, gridSize };
-
-        int vertexIndex = 6 * (m_gridColumns * j + i);
-        
-        sf::Vector2f cellTopLeft        { cell.left                 , cell.top              };
-        sf::Vector2f cellTopRight       { cell.left + cell.width    , cell.top              };
-        sf::Vector2f cellBottomLeft     { cell.left                 , cell.top + cell.width };
-        sf::Vector2f cellBottomRight    { cell.left + cell.width    , cell.top + cell.width };
-        
-        sf::Vector2f tileTopLeft        { tile.left                 , tile.top              };
-        sf::Vector2f tileTopRight       { tile.left + tile.width    , tile.top              };
-        sf::Vector2f tileBottomLeft     { tile.left                 , tile.top + tile.width };
-        sf::Vector2f tileBottomRight    { tile.left + tile.width    , tile.top + tile.width };
-
-        setVertex(vertexIndex++, cellTopLeft, tileTopLeft);
-        setVertex(vertexIndex++, cellTopRight, tileTopRight);
-        setVertex(vertexIndex++, cellBottomLeft, tileBottomLeft);
-        setVertex(vertexIndex++, cellBottomLeft, tileBottomLeft);
-        setVertex(vertexIndex++, cellTopRight, tileTopRight);
-        setVertex(vertexIndex++, cellBottomRight, tileBottomRight);
-    }
+void TileSet::rebuildVertices() {
+    m_dirtyChunks.clear();
+
+    m_chunkColumns = (m_gridColumns + s_chunkSize - 1) / s_chunkSize;
+    m_chunkRows = (m_gridRows + s_chunkSize - 1) / s_chunkSize;
+
+    m_chunks.assign(m_chunkColumns * m_chunkRows, sf::VertexArray { sf::PrimitiveType::Triangles });
+
+    for (int chunkY = 0; chunkY < m_chunkRows; chunkY++)
+    for (int chunkX = 0; chunkX < m_chunkColumns; chunkX++)
+        rebuildChunkVertices(chunkX, chunkY);
+}
+
+void TileSet::rebuildChunkVertices(int chunkX, int chunkY) {
+    sf::VertexArray& chunk = m_chunks[chunkX + chunkY * m_chunkColumns];
+    chunk.clear();
+
+    int lastColumn = std::min(m_gridColumns, (chunkX + 1) * s_chunkSize);
+    int lastRow = std::min(m_gridRows, (chunkY + 1) * s_chunkSize);
+
+    sf::Vector2i cell;
+    for (cell.y = chunkY * s_chunkSize; cell.y < lastRow; cell.y++)
+    for (cell.x = chunkX * s_chunkSize; cell.x < lastColumn; cell.x++)
+    if (m_cells[cell.x + cell.y * m_gridColumns] != TileLayout::s_emptyTile)
+        appendCellVertices(chunk, cell);
+}
+
+void TileSet::appendCellVertices(sf::VertexArray& vertices, const sf::Vector2i& cellIndex) const {
+    const sf::Vector2f& tileSize = m_tileSize;
+    const sf::Vector2f& gridSize = m_cellSize;
+
+    int i = cellIndex.x;
+    int j = cellIndex.y;
+
+    int tileIndex = m_cells[i + j * m_gridColumns];
+
+    int tileColumn = tileIndex % m_tileSetColumns;
+    int tileRow = tileIndex / m_tileSetColumns;
+
+    sf::FloatRect tile {
+        { m_atlasRegion.m_rect.left + tileColumn * tileSize.x, m_atlasRegion.m_rect.top + tileRow * tileSize.y },
+        tileSize
+    };
+    sf::FloatRect cell { { i * gridSize.x, j * gridSize.y }, gridSize };
+    
+    sf::Vector2f cellTopLeft        { cell.left                 , cell.top              };
+    sf::Vector2f cellTopRight       { cell.left + cell.width    , cell.top              };
+    sf::Vector2f cellBottomLeft     { cell.left                 , cell.top + cell.width };
+    sf::Vector2f cellBottomRight    { cell.left + cell.width    , cell.top + cell.width };
+    
+    sf::Vector2f tileTopLeft        { tile.left                 , tile.top              };
+    sf::Vector2f tileTopRight       { tile.left + tile.width    , tile.top              };
+    sf::Vector2f tileBottomLeft     { tile.left                 , tile.top + tile.width };
+    sf::Vector2f tileBottomRight    { tile.left + tile.width    , tile.top + tile.width };
+
+    vertices.append({ cellTopLeft, tileTopLeft });
+    vertices.append({ cellTopRight, tileTopRight });
+    vertices.append({ cellBottomLeft, tileBottomLeft });
+    vertices.append({ cellBottomLeft, tileBottomLeft });
+    vertices.append({ cellTopRight, tileTopRight });
+    vertices.append({ cellBottomRight, tileBottomRight });
 }
 
-int& TileSet::getCellType(const sf::Vector2i& cell) {
+int TileSet::getCellType(const sf::Vector2i& cell) const {
     return m_cells[cell.x + cell.y * m_gridColumns];
 }
 
-sf::FloatRect TileSet::getBounds() const {
-    sf::Vector2u textureSize = m_texture.getSize();
-    sf::Vector2f tileSize {
+void TileSet::setCellType(const sf::Vector2i& cell, int type) {
+    if (type < 0 || type > std::numeric_limits<TileId>::max())
+        throw std::runtime_error("Tile index out of range: " + std::to_string(type));
+
+    TileId& cellType = m_cells[cell.x + cell.y * m_gridColumns];
+    if (cellType == type) return;
+
+    cellType = type;
+    std::uint8_t& solid = m_solid[getSolidityIndex(cell)];
+    if (solid != isWallType(type)) {
+        solid = isWallType(type);
+        m_solidityVersion = ++s_lastSolidityVersion;
+        m_solidCellChangeCount++;
+    }
+
+    m_dirtyChunks.insert(cell.x / s_chunkSize + cell.y / s_chunkSize * m_chunkColumns);
+}
+
+void TileSet::updateCellSize() {
+    sf::Vector2i textureSize = m_atlasRegion.m_rect.getSize();
+    m_tileSize = {
         textureSize.x / static_cast<float>(m_tileSetColumns),
         textureSize.y / static_cast<float>(m_tileSetRows)
     };
 
-    sf::Vector2f gridSize = tileSize * m_scale;
+    m_cellSize = m_tileSize * m_scale;
+}
+
+void TileSet::rebuildSolidity() {
+    // a default constructed tile set has no grid to cover
+    if (m_cells.empty() && m_solid.empty()) return;
+
+    m_solid.assign((m_gridColumns + 2) * (m_gridRows + 2), 0);
+    m_solidityVersion = ++s_lastSolidityVersion;
+    m_solidityRebuildVersion = m_solidityVersion;
+
+    sf::Vector2i cell;
+    for (cell.y = 0; cell.y < m_gridRows; cell.y++)
+    for (cell.x = 0; cell.x < m_gridColumns; cell.x++)
+        m_solid[getSolidityIndex(cell)] = isWallType(m_cells[cell.x + cell.y * m_gridColumns]);
+}
+
+void TileSet::resolveCollisions(std::span<sf::Vector2f> centres, std::span<const sf::Vector2f> halfExtents) const {
+    if (centres.size() != halfExtents.size())
+        throw std::runtime_error("Collision batch has " + std::to_string(centres.size()) + " centres but "
+                                 + std::to_string(halfExtents.size()) + " half extents");
+
+    auto isSolidCell = [this](const sf::Vector2i& cell) { return isSolid(cell); };
+
+    for (size_t i = 0; i < centres.size(); i++)
+        resolveTileCollision(centres[i], halfExtents[i], m_cellSize, isSolidCell);
+}
+
+void TileSet::resolveCollisions(std::span<sf::Vector2f> centres, sf::Vector2f halfExtent) const {
+    auto isSolidCell = [this](const sf::Vector2i& cell) { return isSolid(cell); };
 
+    for (auto& centre : centres)
+        resolveTileCollision(centre, halfExtent, m_cellSize, isSolidCell);
+}
+
+sf::FloatRect TileSet::getBounds() const {
     return sf::FloatRect {
         { 0, 0 },
-        { gridSize.x * m_gridColumns, gridSize.y * m_gridRows }
+        { m_cellSize.x * m_gridColumns, m_cellSize.y * m_gridRows }
     };
 }
 
-sf::FloatRect TileSet::getCellBounds(const sf::Vector2i& cell) {
-    sf::Vector2u textureSize = m_texture.getSize();
-    sf::Vector2f tileSize {
-        textureSize.x / static_cast<float>(m_tileSetColumns),
-        textureSize.y / static_cast<float>(m_tileSetRows)
-    };
-
-    sf::Vector2f gridSize = tileSize * m_scale;
-
-    return {
-        {
-            static_cast<float>(gridSize.x * cell.x),
-            static_cast<float>(gridSize.y * cell.y),
-        },
-        {
-            static_cast<float>(gridSize.x),
-            static_cast<float>(gridSize.y)
-        }
-    };
+void TileSet::writeSnapshot(SnapshotWriter& writer) const {
+    writer.write<std::int32_t>(m_gridColumns);
+    writer.write<std::int32_t>(m_gridRows);
+    writer.writeArray<TileId>(m_cells);
+    writer.writeArray<int>(std::vector<int>(m_wallTypes.begin(), m_wallTypes.end()));
 }
 
-sf::Vector2i TileSet::getCellAtPosition(sf::Vector2f position) {
-    sf::Vector2u textureSize = m_texture.getSize();
-    sf::Vector2f tileSize {
-        textureSize.x / static_cast<float>(m_tileSetColumns),
-        textureSize.y / static_cast<float>(m_tileSetRows)
-    };
+TileSet::Snapshot TileSet::readSnapshot(SnapshotReader& reader) const {
+    std::int32_t gridColumns = reader.read<std::int32_t>();
+    std::int32_t gridRows = reader.read<std::int32_t>();
 
-    sf::Vector2f gridSize = tileSize * m_scale;
+    if (gridColumns != m_gridColumns || gridRows != m_gridRows)
+        throw std::runtime_error("Snapshot map is " + std::to_string(gridColumns) + "x" + std::to_string(gridRows)
+                               + ", expected " + std::to_string(m_gridColumns) + "x" + std::to_string(m_gridRows));
 
-    position.x /= gridSize.x;
-    position.y /= gridSize.y;
+    Snapshot snapshot;
+    reader.readArray(snapshot.m_cells);
+    reader.readArray(snapshot.m_wallTypes);
 
-    return {
-        static_cast<int>(position.x),
-        static_cast<int>(position.y)
-    };
+    if (snapshot.m_cells.size() != m_cells.size())
+        throw std::runtime_error("Snapshot map has " + std::to_string(snapshot.m_cells.size()) + " cells, expected " + std::to_string(m_cells.size()));
+
+    return snapshot;
+}
+
+void TileSet::restoreSnapshot(const Snapshot& snapshot) {
+    std::set<int> snapshotWallTypes(snapshot.m_wallTypes.begin(), snapshot.m_wallTypes.end());
+    bool wallTypesChanged = snapshotWallTypes != m_wallTypes;
+    m_wallTypes = std::move(snapshotWallTypes);
+
+    sf::Vector2i cell;
+    for (cell.y = 0; cell.y < m_gridRows; cell.y++)
+    for (cell.x = 0; cell.x < m_gridColumns; cell.x++) {
+        TileId type = snapshot.m_cells[cell.x + cell.y * m_gridColumns];
+        if (type != m_cells[cell.x + cell.y * m_gridColumns]) setCellType(cell, type);
+    }
+
+    if (wallTypesChanged) rebuildSolidity();
 }
 
 void TileSet::highlightCell(sf::RenderTarget& target, const sf::Vector2i& cell, const sf::Color& color) {
@@ -192,7 +281,27 @@ void TileSet::highlightCell(sf::RenderTarget& target, const sf::Vector2i& cell,
 }
 
 void TileSet::draw(sf::RenderTarget& target) {
+    updateVertices();
+
+    if (m_chunks.empty()) return;
+
     auto states = sf::RenderStates::Default;
-    states.texture = &m_texture;
-    target.draw(m_vertices, states);
+    states.texture = m_atlasRegion.r_texture;
+
+    sf::FloatRect viewBounds = getViewBounds(target.getView());
+    sf::Vector2f viewTopLeft = viewBounds.getPosition();
+    sf::Vector2f viewBottomRight = viewTopLeft + viewBounds.getSize();
+
+    sf::Vector2f chunkSize = m_cellSize * static_cast<float>(s_chunkSize);
+
+    int firstChunkX = std::max(0, static_cast<int>(std::floor(viewTopLeft.x / chunkSize.x)));
+    int firstChunkY = std::max(0, static_cast<int>(std::floor(viewTopLeft.y / chunkSize.y)));
+    int lastChunkX = std::min(m_chunkColumns - 1, static_cast<int>(std::floor(viewBottomRight.x / chunkSize.x)));
+    int lastChunkY = std::min(m_chunkRows - 1, static_cast<int>(std::floor(viewBottomRight.y / chunkSize.y)));
+
+    for (int chunkY = firstChunkY; chunkY <= lastChunkY; chunkY++)
+    for (int chunkX = firstChunkX; chunkX <= lastChunkX; chunkX++) {
+        const sf::VertexArray& chunk = m_chunks[chunkX + chunkY * m_chunkColumns];
+        if (chunk.getVertexCount() > 0) target.draw(chunk, states);
+    }
 }